@@ -0,0 +1,5540 @@
+/*
+ *  libbin2cpp: generation of the C++ source code embedding external files
+ *  (see bin2cpp.h for the API and main.cpp for the command line tool).
+ *
+ *  License:
+ *  - This is free and unencumbered software released into the public domain.
+ *  - For more information, please refer to http://unlicense.org/
+ */
+
+#include "bin2cpp.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <winioctl.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace bin2cpp {
+
+namespace /* anonymous */ {
+
+void notify(const std::function<void(const std::string &)> & callback, const std::string & value) {
+	if (callback) {
+		callback(value);
+	}
+}
+
+// A generated file being written in an output sink
+class OutputFile {
+public:
+	OutputFile(const std::string & fileName, OutputSink & sink, const Progress & progress) :
+		fileName{ fileName }, sink(sink) {
+		notify(progress.onOutputFile, fileName);
+		output = sink.open(fileName);
+	}
+
+	std::ostream & stream() {
+		return *output;
+	}
+
+	void close() {
+		sink.close(fileName, std::move(output));
+	}
+
+private:
+	std::string fileName;
+	OutputSink & sink;
+	std::unique_ptr<std::ostream> output;
+};
+
+// Pool of worker threads running parallel loops
+class ThreadPool {
+public:
+	explicit ThreadPool(unsigned int threadCount) {
+		if (threadCount == 0) {
+			threadCount = std::thread::hardware_concurrency();
+		}
+		for (unsigned int i = 0; i < (threadCount > 0 ? threadCount : 1); ++i) {
+			threads.emplace_back([this, i]() { run(i); });
+		}
+	}
+
+	~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			stopping = true;
+		}
+		wakeUp.notify_all();
+		for (auto & thread : threads) {
+			thread.join();
+		}
+	}
+
+	// Call task(index, workerId) for each index in [0, count) and wait for completion.
+	// The task must not throw.
+	void parallelFor(size_t count, const std::function<void(size_t, unsigned int)> & task) {
+		// a single loop at a time
+		std::lock_guard<std::mutex> loopLock{ loopMutex };
+		std::unique_lock<std::mutex> lock{ mutex };
+		currentTask = &task;
+		taskCount = count;
+		nextIndex = 0;
+		idleThreads = 0;
+		++loopId;
+		wakeUp.notify_all();
+		loopDone.wait(lock, [this]() { return idleThreads == threads.size(); });
+		currentTask = nullptr;
+	}
+
+private:
+	void run(unsigned int workerId) {
+		unsigned long long lastLoopId = 0;
+		std::unique_lock<std::mutex> lock{ mutex };
+		for (;;) {
+			wakeUp.wait(lock, [&]() { return stopping || loopId != lastLoopId; });
+			if (stopping) {
+				return;
+			}
+			lastLoopId = loopId;
+
+			lock.unlock();
+			for (size_t i = nextIndex++; i < taskCount; i = nextIndex++) {
+				(*currentTask)(i, workerId);
+			}
+			lock.lock();
+
+			if (++idleThreads == threads.size()) {
+				loopDone.notify_one();
+			}
+		}
+	}
+
+	std::vector<std::thread> threads;
+	std::mutex loopMutex;
+	std::mutex mutex;
+	std::condition_variable wakeUp;
+	std::condition_variable loopDone;
+	const std::function<void(size_t, unsigned int)> * currentTask = nullptr;
+	size_t taskCount = 0;
+	std::atomic<size_t> nextIndex{ 0 };
+	size_t idleThreads = 0;
+	unsigned long long loopId = 0;
+	bool stopping = false;
+};
+
+// Match a path against a glob pattern ('*' doesn't cross '/', '**' does, '**/' may match no directory, '?' is any character)
+bool matchGlob(const char * pattern, const char * path) {
+	for (; *pattern != '\0'; ++pattern, ++path) {
+		if (*pattern == '*') {
+			const bool crossDirectories = pattern[1] == '*';
+			pattern += crossDirectories ? 2 : 1;
+			if (crossDirectories && *pattern == '/' && matchGlob(pattern + 1, path)) {
+				// "**/" also matches no directory at all
+				return true;
+			}
+			for (;; ++path) {
+				if (matchGlob(pattern, path)) {
+					return true;
+				}
+				if (*path == '\0' || (*path == '/' && !crossDirectories)) {
+					return false;
+				}
+			}
+		}
+		if (*path == '\0' || (*pattern != '?' && *pattern != *path)) {
+			return false;
+		}
+	}
+	return *path == '\0';
+}
+
+bool matchGlob(const std::string & pattern, const std::string & path) {
+	if (pattern.find('/') == std::string::npos) {
+		// match the file name only
+		const auto separator = path.find_last_of('/');
+		return matchGlob(pattern.c_str(), path.c_str() + (separator == std::string::npos ? 0 : separator + 1));
+	}
+	return matchGlob(pattern.c_str(), path.c_str());
+}
+
+// 64-bit FNV-1a hash
+unsigned long long hashData(const std::string & data, unsigned long long hash = 14695981039346656037ULL) {
+	for (unsigned char c : data) {
+		hash = (hash ^ c) * 1099511628211ULL;
+	}
+	return hash;
+}
+
+// CRC32C (Castagnoli polynomial, reflected) lookup table
+const unsigned int * crc32cTable() {
+	static const std::vector<unsigned int> table = []() {
+		std::vector<unsigned int> values(256);
+		for (unsigned int i = 0; i < 256; ++i) {
+			unsigned int crc = i;
+			for (int bit = 0; bit < 8; ++bit) {
+				crc = (crc & 1) ? (crc >> 1) ^ 0x82F63B78 : crc >> 1;
+			}
+			values[i] = crc;
+		}
+		return values;
+	}();
+	return table.data();
+}
+
+std::string readFile(const fs::path & fileName) {
+	std::ifstream inputFile{ fileName, std::ios_base::in | std::ios_base::binary };
+	if (!inputFile) {
+		throw std::runtime_error{ "Failed to open file " + fileName.generic_string() };
+	}
+	std::ostringstream data;
+	data << inputFile.rdbuf();
+	return data.str();
+}
+
+void writeFile(const fs::path & fileName, const std::string & data) {
+	std::ofstream outputFile{ fileName, std::ios_base::out | std::ios_base::binary };
+	if (!outputFile.write(data.data(), data.size())) {
+		throw std::runtime_error{ "Failed to write file " + fileName.generic_string() };
+	}
+}
+
+// Write a file of a cache shared by the processes: the data goes to a temporary file renamed into place,
+// so the other processes never read a partially written file
+void writeCacheFile(const fs::path & fileName, const std::string & data) {
+	std::ostringstream suffix;
+	suffix << ".tmp-" << std::hex << std::hash<std::thread::id>{}(std::this_thread::get_id()) << "-" << std::chrono::steady_clock::now().time_since_epoch().count();
+	const fs::path tempFile = fileName.generic_string() + suffix.str();
+	try {
+		writeFile(tempFile, data);
+		fs::rename(tempFile, fileName);
+	}
+	catch (...) {
+		std::error_code ignored;
+		fs::remove(tempFile, ignored);
+		throw;
+	}
+}
+
+// Remove the whitespaces outside of the JSON strings
+std::string minifyJson(const std::string & data) {
+	std::string result;
+	result.reserve(data.size());
+	bool inString = false;
+	for (size_t i = 0; i < data.size(); ++i) {
+		const char c = data[i];
+		if (inString) {
+			result += c;
+			if (c == '\\' && i + 1 < data.size()) {
+				result += data[++i];
+			}
+			else if (c == '"') {
+				inString = false;
+			}
+		}
+		else if (c == '"') {
+			inString = true;
+			result += c;
+		}
+		else if (c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+			result += c;
+		}
+	}
+	return result;
+}
+
+// Remove the indentation, the trailing whitespaces and the blank lines (line breaks are kept for preprocessor directives)
+std::string stripWhitespaces(const std::string & data) {
+	std::string result;
+	result.reserve(data.size());
+	size_t lineStart = 0;
+	while (lineStart < data.size()) {
+		auto lineEnd = data.find('\n', lineStart);
+		if (lineEnd == std::string::npos) {
+			lineEnd = data.size();
+		}
+		const auto first = data.find_first_not_of(" \t\r", lineStart);
+		if (first != std::string::npos && first < lineEnd) {
+			const auto last = data.find_last_not_of(" \t\r", lineEnd - 1);
+			result.append(data, first, last - first + 1);
+			result += '\n';
+		}
+		lineStart = lineEnd + 1;
+	}
+	return result;
+}
+
+// Run an external command with the given data as stdin and return its stdout
+std::string runTransformCommand(const std::string & command, const std::string & data, const fs::path & workFile) {
+	const fs::path inputFile = workFile.generic_string() + ".in";
+	const fs::path outputFile = workFile.generic_string() + ".out";
+	writeFile(inputFile, data);
+	const std::string commandLine = command + " < \"" + inputFile.generic_string() + "\" > \"" + outputFile.generic_string() + "\"";
+	const int status = std::system(commandLine.c_str());
+	fs::remove(inputFile);
+	if (status != 0) {
+		fs::remove(outputFile);
+		throw std::runtime_error{ "Transform command failed: " + commandLine };
+	}
+	std::string result = readFile(outputFile);
+	fs::remove(outputFile);
+	return result;
+}
+
+std::string applyTransform(const std::string & transform, const std::string & data, const fs::path & workFile) {
+	if (transform == "json") {
+		return minifyJson(data);
+	}
+	if (transform == "strip") {
+		return stripWhitespaces(data);
+	}
+	return runTransformCommand(transform.substr(4), data, workFile);
+}
+
+// Streaming decoder of deflate data (RFC 1951), raw or made of gzip members (RFC 1952), reading the compressed archives.
+// Only the last 32 KB of decompressed data are kept, as a stream buffer the data is read with the std::istream functions.
+class Inflater : public std::streambuf {
+public:
+	// Decompress the data read from the current position of input
+	Inflater(std::istream & input, bool gzip) :
+		input{ input }, gzip{ gzip }, inputOffset{ static_cast<unsigned long long>(input.tellg()) } {
+		setg(output.data(), output.data(), output.data());
+		if (gzip) {
+			gzipHeader();
+		}
+	}
+
+	// Resume the decompression of a gzip stream at a checkpoint
+	Inflater(std::istream & input, const ArchiveCheckpoint & checkpoint) :
+		input{ input }, gzip{ true }, inputOffset{ checkpoint.inputBitPosition / 8 } {
+		if (!input.seekg(inputOffset)) {
+			throw std::runtime_error{ "Truncated gzip data" };
+		}
+		consume(checkpoint.inputBitPosition % 8);
+		std::copy(checkpoint.window.begin(), checkpoint.window.end(), output.begin());
+		outputEnd = checkpoint.window.size();
+		outputOffset = checkpoint.offset - outputEnd;
+		setg(output.data(), output.data() + outputEnd, output.data() + outputEnd);
+	}
+
+	// Position in the decompressed data
+	unsigned long long position() const {
+		return outputOffset + static_cast<unsigned long long>(gptr() - eback());
+	}
+
+	// Save a checkpoint at the first block starting after every interval bytes of decompressed data (gzip only)
+	void saveCheckpoints(std::vector<ArchiveCheckpoint> & list, unsigned long long interval) {
+		checkpoints = &list;
+		checkpointInterval = interval;
+		nextCheckpoint = position() + interval;
+	}
+
+protected:
+	int_type underflow() override {
+		if (gptr() == egptr() && state != State::end) {
+			if (outputEnd + s_maxMatchSize > output.size()) {
+				// only the window is kept, the distances of the next matches are at most 32 KB
+				std::copy(output.begin() + (outputEnd - s_windowSize), output.begin() + outputEnd, output.begin());
+				outputOffset += outputEnd - s_windowSize;
+				outputEnd = s_windowSize;
+			}
+			// all the data decompressed so far was read
+			const size_t read = outputEnd;
+			decode();
+			setg(output.data(), output.data() + read, output.data() + outputEnd);
+		}
+		return gptr() == egptr() ? traits_type::eof() : traits_type::to_int_type(*gptr());
+	}
+
+	pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode) override {
+		// only forward, the data being skipped is decompressed
+		const unsigned long long current = position();
+		const unsigned long long target = direction == std::ios_base::cur ? current + offset :
+			direction == std::ios_base::beg ? static_cast<unsigned long long>(offset) : 0;
+		if ((direction != std::ios_base::cur && direction != std::ios_base::beg) || target < current) {
+			return pos_type(off_type(-1));
+		}
+		for (unsigned long long remaining = target - current; remaining > 0;) {
+			if (gptr() == egptr() && traits_type::eq_int_type(underflow(), traits_type::eof())) {
+				return pos_type(off_type(-1));
+			}
+			const size_t count = static_cast<size_t>(std::min<unsigned long long>(remaining, egptr() - gptr()));
+			gbump(static_cast<int>(count));
+			remaining -= count;
+		}
+		return pos_type(off_type(target));
+	}
+
+	pos_type seekpos(pos_type position, std::ios_base::openmode mode) override {
+		return seekoff(off_type(position), std::ios_base::beg, mode);
+	}
+
+private:
+	static const unsigned int s_fastBits = 9;
+	static const size_t s_windowSize = 32768;
+	static const size_t s_maxMatchSize = 258;
+
+	// canonical Huffman code, the codes of at most s_fastBits bits are decoded with a single table lookup
+	struct Huffman {
+		// length << 9 | symbol of the code starting with the next (reversed) input bits, 0 for the longer codes
+		unsigned short fast[1 << s_fastBits];
+		// first code of each length, its index in symbols, and the end of the codes of each length (aligned on 16 bits)
+		unsigned int firstCode[16];
+		unsigned int firstIndex[16];
+		unsigned int endCode[17];
+		// symbols sorted by code
+		unsigned short symbols[288];
+	};
+
+	static unsigned int reverseBits(unsigned int value, unsigned int count) {
+		unsigned int result = 0;
+		for (unsigned int i = 0; i < count; ++i) {
+			result = (result << 1) | ((value >> i) & 1);
+		}
+		return result;
+	}
+
+	static void buildHuffman(Huffman & huffman, const unsigned char * lengths, unsigned int count) {
+		std::fill(std::begin(huffman.fast), std::end(huffman.fast), static_cast<unsigned short>(0));
+		unsigned int counts[16] = {};
+		for (unsigned int i = 0; i < count; ++i) {
+			++counts[lengths[i]];
+		}
+		unsigned int nextCode[16] = {};
+		unsigned int code = 0;
+		unsigned int index = 0;
+		for (unsigned int length = 1; length < 16; ++length) {
+			nextCode[length] = code;
+			huffman.firstCode[length] = code;
+			huffman.firstIndex[length] = index;
+			code += counts[length];
+			index += counts[length];
+			if (code > (1u << length)) {
+				throw std::runtime_error{ "Invalid deflate code lengths" };
+			}
+			huffman.endCode[length] = code << (16 - length);
+			code <<= 1;
+		}
+		huffman.endCode[16] = 0x10000;
+
+		for (unsigned int i = 0; i < count; ++i) {
+			const unsigned int length = lengths[i];
+			if (length == 0) {
+				continue;
+			}
+			huffman.symbols[nextCode[length] - huffman.firstCode[length] + huffman.firstIndex[length]] = static_cast<unsigned short>(i);
+			if (length <= s_fastBits) {
+				// the deflate codes are stored from their most significant bit: the table is indexed by the reversed code,
+				// followed by any bits
+				for (unsigned int j = reverseBits(nextCode[length], length); j < (1u << s_fastBits); j += 1u << length) {
+					huffman.fast[j] = static_cast<unsigned short>((length << 9) | i);
+				}
+			}
+			++nextCode[length];
+		}
+	}
+
+	static const std::pair<Huffman, Huffman> & fixedTables() {
+		static const std::pair<Huffman, Huffman> tables = []() {
+			std::pair<Huffman, Huffman> result;
+			unsigned char lengths[288];
+			std::fill(lengths, lengths + 144, static_cast<unsigned char>(8));
+			std::fill(lengths + 144, lengths + 256, static_cast<unsigned char>(9));
+			std::fill(lengths + 256, lengths + 280, static_cast<unsigned char>(7));
+			std::fill(lengths + 280, lengths + 288, static_cast<unsigned char>(8));
+			buildHuffman(result.first, lengths, 288);
+			std::fill(lengths, lengths + 30, static_cast<unsigned char>(5));
+			buildHuffman(result.second, lengths, 30);
+			return result;
+		}();
+		return tables;
+	}
+
+	// Fill the bit buffer with at least 57 bits, the missing bits after the end of the input are zeros
+	void refill() {
+		while (bitCount <= 56) {
+			if (inputPosition == inputEnd) {
+				inputOffset += inputEnd;
+				input.read(inputBuffer.data(), static_cast<std::streamsize>(inputBuffer.size()));
+				inputEnd = static_cast<size_t>(input.gcount());
+				inputPosition = 0;
+				if (inputEnd == 0) {
+					paddingBits += 8;
+					bitCount += 8;
+					continue;
+				}
+			}
+			bitBuffer |= static_cast<unsigned long long>(static_cast<unsigned char>(inputBuffer[inputPosition++])) << bitCount;
+			bitCount += 8;
+		}
+	}
+
+	void consume(unsigned int count) {
+		if (bitCount < count) {
+			refill();
+		}
+		if (count + paddingBits > bitCount) {
+			throw std::runtime_error{ "Truncated deflate data" };
+		}
+		bitBuffer >>= count;
+		bitCount -= count;
+	}
+
+	unsigned int bits(unsigned int count) {
+		if (bitCount < count) {
+			refill();
+		}
+		const unsigned int value = static_cast<unsigned int>(bitBuffer & ((1ull << count) - 1));
+		consume(count);
+		return value;
+	}
+
+	// the remaining bits of the current byte are padding
+	void alignToByte() {
+		consume(bitCount % 8);
+	}
+
+	bool inputEnded() {
+		refill();
+		return bitCount == paddingBits;
+	}
+
+	// position of the next input bit in the input stream
+	unsigned long long inputBitPosition() const {
+		return (inputOffset + inputPosition) * 8 - (bitCount - paddingBits);
+	}
+
+	unsigned int decode(const Huffman & huffman) {
+		if (bitCount < 16) {
+			refill();
+		}
+		const unsigned int fast = huffman.fast[bitBuffer & ((1u << s_fastBits) - 1)];
+		if (fast != 0) {
+			consume(fast >> 9);
+			return fast & 0x1FF;
+		}
+		// the codes of a given length are consecutive, compared from their most significant bit
+		const unsigned int code = reverseBits(static_cast<unsigned int>(bitBuffer & 0xFFFF), 16);
+		unsigned int length = s_fastBits + 1;
+		while (code >= huffman.endCode[length]) {
+			++length;
+		}
+		if (length == 16) {
+			throw std::runtime_error{ "Invalid deflate code" };
+		}
+		consume(length);
+		return huffman.symbols[(code >> (16 - length)) - huffman.firstCode[length] + huffman.firstIndex[length]];
+	}
+
+	void gzipHeader() {
+		if (bits(16) != 0x8B1F || bits(8) != 8) {
+			throw std::runtime_error{ "Invalid gzip data" };
+		}
+		const unsigned int flags = bits(8);
+		// modification time, extra flags and operating system
+		consume(48);
+		if (flags & 4) {
+			// extra field
+			for (unsigned int size = bits(16); size > 0; --size) {
+				consume(8);
+			}
+		}
+		for (unsigned int flag : { 8, 16 }) {
+			// zero terminated file name and comment
+			if (flags & flag) {
+				while (bits(8) != 0) {
+				}
+			}
+		}
+		if (flags & 2) {
+			// header CRC
+			consume(16);
+		}
+	}
+
+	// Decompress the next data into the output buffer, until it's full or the end of the data
+	void decode() {
+		while (outputEnd + s_maxMatchSize <= output.size()) {
+			if (state == State::stored) {
+				const size_t count = std::min<size_t>(storedSize, output.size() - outputEnd);
+				for (size_t i = 0; i < count; ++i) {
+					output[outputEnd++] = static_cast<char>(bits(8));
+				}
+				storedSize -= count;
+				if (storedSize == 0) {
+					state = State::blockHeader;
+				}
+			}
+			else if (state == State::codes) {
+				compressedData();
+			}
+			else if (state == State::blockHeader) {
+				if (!blockHeader()) {
+					return;
+				}
+			}
+			else {
+				return;
+			}
+		}
+	}
+
+	// Start the next block, returns false at the end of the data
+	bool blockHeader() {
+		if (lastBlock) {
+			if (!gzip) {
+				state = State::end;
+				return false;
+			}
+			// CRC32 and size of the gzip member, possibly followed by another member
+			alignToByte();
+			consume(32);
+			consume(32);
+			if (inputEnded()) {
+				state = State::end;
+				return false;
+			}
+			gzipHeader();
+			lastBlock = false;
+		}
+		else if (checkpoints && outputOffset + outputEnd >= nextCheckpoint) {
+			ArchiveCheckpoint checkpoint;
+			checkpoint.offset = outputOffset + outputEnd;
+			checkpoint.inputBitPosition = inputBitPosition();
+			const size_t windowSize = outputEnd < s_windowSize ? outputEnd : s_windowSize;
+			checkpoint.window.assign(output.data() + outputEnd - windowSize, windowSize);
+			checkpoints->push_back(std::move(checkpoint));
+			nextCheckpoint = outputOffset + outputEnd + checkpointInterval;
+		}
+
+		lastBlock = bits(1) != 0;
+		const unsigned int type = bits(2);
+		if (type == 0) {
+			alignToByte();
+			const unsigned int size = bits(16);
+			if (bits(16) != (~size & 0xFFFF)) {
+				throw std::runtime_error{ "Invalid deflate stored block" };
+			}
+			storedSize = size;
+			state = size == 0 ? State::blockHeader : State::stored;
+		}
+		else if (type == 1) {
+			literals = &fixedTables().first;
+			distances = &fixedTables().second;
+			state = State::codes;
+		}
+		else if (type == 2) {
+			dynamicTables();
+			literals = &dynamicLiterals;
+			distances = &dynamicDistances;
+			state = State::codes;
+		}
+		else {
+			throw std::runtime_error{ "Invalid deflate block type" };
+		}
+		return true;
+	}
+
+	void compressedData() {
+		static const unsigned short lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+		static const unsigned char lengthBits[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+		static const unsigned short distanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+		static const unsigned char distanceBits[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+		char * data = output.data();
+		// a match is never split, the buffer is flushed before it could overflow
+		while (outputEnd + s_maxMatchSize <= output.size()) {
+			unsigned int symbol = decode(*literals);
+			if (symbol < 256) {
+				data[outputEnd++] = static_cast<char>(symbol);
+			}
+			else if (symbol == 256) {
+				state = State::blockHeader;
+				return;
+			}
+			else {
+				symbol -= 257;
+				if (symbol >= 29) {
+					throw std::runtime_error{ "Invalid deflate length" };
+				}
+				const size_t length = lengthBase[symbol] + bits(lengthBits[symbol]);
+				const unsigned int distanceSymbol = decode(*distances);
+				if (distanceSymbol >= 30) {
+					throw std::runtime_error{ "Invalid deflate distance" };
+				}
+				const size_t distance = distanceBase[distanceSymbol] + bits(distanceBits[distanceSymbol]);
+				if (distance > outputEnd) {
+					throw std::runtime_error{ "Invalid deflate distance" };
+				}
+				// the copy may overlap the bytes it appends
+				const char * from = data + outputEnd - distance;
+				char * to = data + outputEnd;
+				for (size_t i = 0; i < length; ++i) {
+					to[i] = from[i];
+				}
+				outputEnd += length;
+			}
+		}
+	}
+
+	void dynamicTables() {
+		static const unsigned char order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+		const unsigned int literalCount = bits(5) + 257;
+		const unsigned int distanceCount = bits(5) + 1;
+		const unsigned int codeLengthCount = bits(4) + 4;
+		if (literalCount > 286 || distanceCount > 30) {
+			throw std::runtime_error{ "Invalid deflate dynamic block" };
+		}
+
+		unsigned char lengths[288 + 32] = {};
+		for (unsigned int i = 0; i < codeLengthCount; ++i) {
+			lengths[order[i]] = static_cast<unsigned char>(bits(3));
+		}
+		Huffman codeLengths;
+		buildHuffman(codeLengths, lengths, 19);
+
+		// the literal and distance code lengths form a single sequence (repeats can cross them)
+		unsigned int count = 0;
+		while (count < literalCount + distanceCount) {
+			const unsigned int symbol = decode(codeLengths);
+			if (symbol < 16) {
+				lengths[count++] = static_cast<unsigned char>(symbol);
+				continue;
+			}
+			unsigned char length = 0;
+			unsigned int repeat;
+			if (symbol == 16) {
+				if (count == 0) {
+					throw std::runtime_error{ "Invalid deflate dynamic block" };
+				}
+				length = lengths[count - 1];
+				repeat = 3 + bits(2);
+			}
+			else if (symbol == 17) {
+				repeat = 3 + bits(3);
+			}
+			else {
+				repeat = 11 + bits(7);
+			}
+			if (count + repeat > literalCount + distanceCount) {
+				throw std::runtime_error{ "Invalid deflate dynamic block" };
+			}
+			std::fill(lengths + count, lengths + count + repeat, length);
+			count += repeat;
+		}
+
+		buildHuffman(dynamicLiterals, lengths, literalCount);
+		buildHuffman(dynamicDistances, lengths + literalCount, distanceCount);
+	}
+
+	enum class State { blockHeader, stored, codes, end };
+
+	std::istream & input;
+	const bool gzip;
+	std::vector<char> inputBuffer = std::vector<char>(65536);
+	size_t inputPosition = 0;
+	size_t inputEnd = 0;
+	// position of inputBuffer in the input stream
+	unsigned long long inputOffset;
+	unsigned long long bitBuffer = 0;
+	unsigned int bitCount = 0;
+	// zero bits added after the end of the input
+	unsigned int paddingBits = 0;
+
+	State state = State::blockHeader;
+	bool lastBlock = false;
+	size_t storedSize = 0;
+	const Huffman * literals = nullptr;
+	const Huffman * distances = nullptr;
+	Huffman dynamicLiterals;
+	Huffman dynamicDistances;
+
+	// the decompressed data, starting with the window of the previous data
+	std::vector<char> output = std::vector<char>(4 * s_windowSize);
+	size_t outputEnd = 0;
+	// position of the output buffer in the decompressed data
+	unsigned long long outputOffset = 0;
+
+	std::vector<ArchiveCheckpoint> * checkpoints = nullptr;
+	unsigned long long checkpointInterval = 0;
+	unsigned long long nextCheckpoint = 0;
+};
+
+unsigned long long readLittleEndian(const std::string & data, size_t position, unsigned int size) {
+	if (position > data.size() || data.size() - position < size) {
+		throw std::runtime_error{ "Truncated archive" };
+	}
+	unsigned long long value = 0;
+	for (unsigned int i = 0; i < size; ++i) {
+		value |= static_cast<unsigned long long>(static_cast<unsigned char>(data[position + i])) << (8 * i);
+	}
+	return value;
+}
+
+// Read size bytes at the given position of a file
+std::string readFileRange(std::istream & file, unsigned long long position, size_t size) {
+	std::string data(size, '\0');
+	if (!file.seekg(position) || !file.read(&data[0], static_cast<std::streamsize>(size))) {
+		throw std::runtime_error{ "Truncated archive" };
+	}
+	return data;
+}
+
+// Kind of archive given by the extension of the file name: "tar", "tar.gz", "zip" or empty
+std::string archiveKind(const std::string & path) {
+	const auto endsWith = [&](const std::string & suffix) {
+		return path.size() > suffix.size() && path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+	};
+	if (endsWith(".tar")) {
+		return "tar";
+	}
+	if (endsWith(".tar.gz") || endsWith(".tgz")) {
+		return "tar.gz";
+	}
+	if (endsWith(".zip")) {
+		return "zip";
+	}
+	return std::string{};
+}
+
+// Remove the leading "./" and '/' of an archive member path
+std::string memberPath(std::string path) {
+	while (!path.empty() && (path[0] == '/' || path.compare(0, 2, "./") == 0)) {
+		path.erase(0, path[0] == '/' ? 1 : 2);
+	}
+	return path;
+}
+
+// Maximum size of the long names and pax headers of a tar archive
+const unsigned long long s_maxTarRecordSize = 1024 * 1024;
+
+// List the regular files of a tar stream (ustar, with the GNU and pax long names), only the headers are read:
+// the data of the members is skipped with seekg()
+std::vector<std::pair<std::string, ArchiveMember>> listTarMembers(std::istream & stream, unsigned long long streamSize) {
+	std::string header(512, '\0');
+	const auto field = [&](size_t position, size_t size) {
+		const std::string value = header.substr(position, size);
+		return value.substr(0, value.find('\0'));
+	};
+	const auto number = [&](size_t position, size_t size) {
+		unsigned long long value = 0;
+		if (static_cast<unsigned char>(header[position]) & 0x80) {
+			// base-256 encoding of the large sizes
+			for (size_t i = 1; i < size; ++i) {
+				value = (value << 8) | static_cast<unsigned char>(header[position + i]);
+			}
+			return value;
+		}
+		for (size_t i = 0; i < size && header[position + i] >= '0' && header[position + i] <= '7'; ++i) {
+			value = value * 8 + (header[position + i] - '0');
+		}
+		return value;
+	};
+	const auto readData = [&](unsigned long long size) {
+		if (size > s_maxTarRecordSize) {
+			throw std::runtime_error{ "Unsupported tar record size" };
+		}
+		std::string data(static_cast<size_t>(size), '\0');
+		if (!stream.read(&data[0], static_cast<std::streamsize>(size))) {
+			throw std::runtime_error{ "Truncated tar archive" };
+		}
+		return data;
+	};
+
+	std::vector<std::pair<std::string, ArchiveMember>> members;
+	std::string longName;
+	while (stream.read(&header[0], 512) && header[0] != '\0') {
+		const unsigned long long size = number(124, 12);
+		const char type = header[156];
+		const unsigned long long dataPosition = static_cast<unsigned long long>(stream.tellg());
+		if (size > streamSize - dataPosition) {
+			throw std::runtime_error{ "Truncated tar archive" };
+		}
+
+		if (type == 'L') {
+			// GNU long name of the next member
+			const std::string data = readData(size);
+			longName = data.substr(0, data.find('\0'));
+		}
+		else if (type == 'x') {
+			// pax extended header of the next member: "<length> <key>=<value>\n" records
+			const std::string data = readData(size);
+			size_t record = 0;
+			while (record < data.size()) {
+				const size_t length = std::strtoul(data.c_str() + record, nullptr, 10);
+				const size_t key = data.find(' ', record) + 1;
+				if (length == 0 || key == 0 || key > record + length || record + length > data.size()) {
+					break;
+				}
+				if (data.compare(key, 5, "path=") == 0) {
+					longName = data.substr(key + 5, record + length - key - 6);
+				}
+				record += length;
+			}
+		}
+		else {
+			if (type == '0' || type == '\0' || type == '7') {
+				std::string name = longName;
+				if (name.empty()) {
+					name = field(0, 100);
+					// the prefix field is only defined by the POSIX format (GNU tar stores other fields there)
+					if (header.compare(257, 6, std::string{ "ustar\0", 6 }) == 0 && header[345] != '\0') {
+						name = field(345, 155) + "/" + name;
+					}
+				}
+				ArchiveMember member;
+				member.offset = dataPosition;
+				member.storedSize = size;
+				member.size = size;
+				members.emplace_back(memberPath(name), member);
+				longName.clear();
+			}
+			else if (type != 'g') {
+				// directories, links, ... aren't embedded
+				longName.clear();
+			}
+			if (size > 0 && !stream.seekg(static_cast<std::streamoff>(size), std::ios_base::cur)) {
+				throw std::runtime_error{ "Truncated tar archive" };
+			}
+		}
+		// the data is padded to a multiple of 512 bytes (the padding of the last member may be missing)
+		const unsigned long long padding = (512 - size % 512) % 512;
+		if (padding > 0 && !stream.seekg(static_cast<std::streamoff>(padding), std::ios_base::cur)) {
+			break;
+		}
+	}
+	return members;
+}
+
+// List the files of a zip archive from its central directory (stored or deflated members, without zip64)
+std::vector<std::pair<std::string, ArchiveMember>> listZipMembers(std::istream & file, unsigned long long fileSize) {
+	// the end of central directory record is followed by a comment of at most 64 KB
+	const size_t tailSize = static_cast<size_t>(std::min<unsigned long long>(fileSize, 22 + 0xFFFF));
+	const std::string tail = readFileRange(file, fileSize - tailSize, tailSize);
+	size_t end = tail.size() < 22 ? std::string::npos : tail.size() - 22;
+	while (end != std::string::npos && readLittleEndian(tail, end, 4) != 0x06054B50) {
+		end = end == 0 ? std::string::npos : end - 1;
+	}
+	if (end == std::string::npos) {
+		throw std::runtime_error{ "Invalid zip archive" };
+	}
+
+	std::vector<std::pair<std::string, ArchiveMember>> members;
+	const auto count = readLittleEndian(tail, end + 10, 2);
+	const auto directorySize = readLittleEndian(tail, end + 12, 4);
+	const auto directoryOffset = readLittleEndian(tail, end + 16, 4);
+	if (directoryOffset > fileSize || fileSize - directoryOffset < directorySize) {
+		throw std::runtime_error{ "Invalid zip central directory" };
+	}
+	const std::string directory = readFileRange(file, directoryOffset, static_cast<size_t>(directorySize));
+	size_t entry = 0;
+	for (unsigned long long i = 0; i < count; ++i) {
+		if (readLittleEndian(directory, entry, 4) != 0x02014B50) {
+			throw std::runtime_error{ "Invalid zip central directory" };
+		}
+		const auto flags = readLittleEndian(directory, entry + 8, 2);
+		const auto method = readLittleEndian(directory, entry + 10, 2);
+		const auto nameSize = static_cast<size_t>(readLittleEndian(directory, entry + 28, 2));
+		if (entry + 46 > directory.size() || directory.size() - entry - 46 < nameSize) {
+			throw std::runtime_error{ "Invalid zip central directory" };
+		}
+		const std::string name = directory.substr(entry + 46, nameSize);
+		ArchiveMember member;
+		member.storedSize = readLittleEndian(directory, entry + 20, 4);
+		member.size = readLittleEndian(directory, entry + 24, 4);
+		const auto header = readLittleEndian(directory, entry + 42, 4);
+		entry += 46 + nameSize + static_cast<size_t>(readLittleEndian(directory, entry + 30, 2) + readLittleEndian(directory, entry + 32, 2));
+
+		if (name.empty() || name.back() == '/') {
+			// directory
+			continue;
+		}
+		if (member.storedSize == 0xFFFFFFFF || member.size == 0xFFFFFFFF || header == 0xFFFFFFFF) {
+			throw std::runtime_error{ "Unsupported zip64 member " + name };
+		}
+		if (flags & 1) {
+			throw std::runtime_error{ "Unsupported encrypted zip member " + name };
+		}
+		if (method != 0 && method != 8) {
+			throw std::runtime_error{ "Unsupported zip compression method for " + name };
+		}
+		// only the fixed part of the local header is read, to skip its variable fields
+		const std::string localHeader = readFileRange(file, header, 30);
+		if (readLittleEndian(localHeader, 0, 4) != 0x04034B50) {
+			throw std::runtime_error{ "Invalid zip local header for " + name };
+		}
+		member.offset = header + 30 + readLittleEndian(localHeader, 26, 2) + readLittleEndian(localHeader, 28, 2);
+		member.deflated = method == 8;
+		if (member.offset + member.storedSize > fileSize) {
+			throw std::runtime_error{ "Truncated zip archive" };
+		}
+		members.emplace_back(memberPath(name), member);
+	}
+	return members;
+}
+
+// Decompressed data between two checkpoints of a .tar.gz
+const unsigned long long s_archiveCheckpointInterval = 8 * 1024 * 1024;
+
+// List the members of an archive without keeping their data: a .tar.gz is decompressed once to read its headers,
+// saving the checkpoints its members are decompressed from by the generator
+std::vector<std::pair<std::string, ArchiveMember>> listArchiveMembers(const std::string & path) {
+	std::ifstream file{ path, std::ios_base::in | std::ios_base::binary };
+	if (!file) {
+		throw std::runtime_error{ "Failed to open file " + path };
+	}
+	const std::string kind = archiveKind(path);
+	if (kind == "zip") {
+		return listZipMembers(file, fs::file_size(path));
+	}
+	if (kind == "tar") {
+		return listTarMembers(file, fs::file_size(path));
+	}
+
+	std::shared_ptr<std::vector<ArchiveCheckpoint>> checkpoints{ new std::vector<ArchiveCheckpoint> };
+	Inflater inflater{ file, true };
+	inflater.saveCheckpoints(*checkpoints, s_archiveCheckpointInterval);
+	std::istream tarStream{ &inflater };
+	tarStream.exceptions(std::ios_base::badbit);
+	auto members = listTarMembers(tarStream, std::numeric_limits<unsigned long long>::max());
+	for (auto & member : members) {
+		member.second.checkpoints = checkpoints;
+	}
+	return members;
+}
+
+// A .tar.gz being decompressed, kept by ArchiveStreams between the members read from it
+struct ArchiveStream {
+	explicit ArchiveStream(const std::string & path) : file{ path, std::ios_base::in | std::ios_base::binary } {
+		if (!file) {
+			throw std::runtime_error{ "Failed to open file " + path };
+		}
+	}
+
+	std::ifstream file;
+	std::unique_ptr<Inflater> inflater;
+};
+
+// The .tar.gz decompressed by the generator: the members are mostly read in order, so a member is decompressed from
+// where a previous one ended, or else from the closest checkpoint before it
+class ArchiveStreams {
+public:
+	// Decompression positioned at the data of a member
+	std::unique_ptr<ArchiveStream> acquire(const ArchiveMember & member) {
+		const ArchiveCheckpoint * checkpoint = nullptr;
+		if (member.checkpoints) {
+			const auto & list = *member.checkpoints;
+			const auto next = std::upper_bound(list.begin(), list.end(), member.offset, [](unsigned long long offset, const ArchiveCheckpoint & checkpoint) {
+				return offset < checkpoint.offset;
+			});
+			if (next != list.begin()) {
+				checkpoint = &*std::prev(next);
+			}
+		}
+
+		std::unique_ptr<ArchiveStream> stream;
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			auto best = idle.end();
+			const auto streams = idle.equal_range(member.archive);
+			for (auto it = streams.first; it != streams.second; ++it) {
+				const unsigned long long position = it->second->inflater->position();
+				if (position <= member.offset && (!checkpoint || position >= checkpoint->offset) &&
+					(best == idle.end() || position > best->second->inflater->position())) {
+					best = it;
+				}
+			}
+			if (best != idle.end()) {
+				stream = std::move(best->second);
+				idle.erase(best);
+			}
+		}
+		if (!stream) {
+			stream.reset(new ArchiveStream{ member.archive });
+			stream->inflater.reset(checkpoint ? new Inflater{ stream->file, *checkpoint } : new Inflater{ stream->file, true });
+		}
+		const auto skipped = static_cast<std::streamoff>(member.offset - stream->inflater->position());
+		if (stream->inflater->pubseekoff(skipped, std::ios_base::cur) == std::streampos(std::streamoff(-1))) {
+			throw std::runtime_error{ "Truncated archive " + member.archive };
+		}
+		return stream;
+	}
+
+	// Keep a decompression for the next members
+	void release(const std::string & archive, std::unique_ptr<ArchiveStream> stream) {
+		std::lock_guard<std::mutex> lock{ mutex };
+		idle.emplace(archive, std::move(stream));
+		if (idle.count(archive) > s_maxIdleStreams) {
+			idle.erase(idle.find(archive));
+		}
+	}
+
+	void clear() {
+		std::lock_guard<std::mutex> lock{ mutex };
+		idle.clear();
+	}
+
+private:
+	static const size_t s_maxIdleStreams = 16;
+
+	std::mutex mutex;
+	std::multimap<std::string, std::unique_ptr<ArchiveStream>> idle;
+};
+
+// Data of an archive member, read from its archive and decompressed by chunks
+class MemberBuffer : public std::streambuf {
+public:
+	MemberBuffer(const ArchiveMember & member, ArchiveStreams & streams) :
+		member{ member }, streams{ streams }, remaining{ member.size } {
+		if (archiveKind(member.archive) == "tar.gz") {
+			archiveStream = streams.acquire(member);
+			source = archiveStream->inflater.get();
+			return;
+		}
+		file.open(member.archive, std::ios_base::in | std::ios_base::binary);
+		if (!file || !file.seekg(member.offset)) {
+			throw std::runtime_error{ "Failed to open file " + member.archive };
+		}
+		if (member.deflated) {
+			inflater.reset(new Inflater{ file, false });
+			source = inflater.get();
+		}
+		else {
+			source = file.rdbuf();
+		}
+	}
+
+	~MemberBuffer() {
+		// the decompression continues with the next members, unless it stopped in the middle of this one
+		if (archiveStream && remaining == 0) {
+			streams.release(member.archive, std::move(archiveStream));
+		}
+	}
+
+protected:
+	int_type underflow() override {
+		if (gptr() == egptr() && remaining > 0) {
+			const std::streamsize count = source->sgetn(buffer.data(), static_cast<std::streamsize>(std::min<unsigned long long>(remaining, buffer.size())));
+			if (count <= 0) {
+				throw std::runtime_error{ "Truncated archive " + member.archive };
+			}
+			remaining -= static_cast<unsigned long long>(count);
+			setg(buffer.data(), buffer.data(), buffer.data() + count);
+		}
+		return gptr() == egptr() ? traits_type::eof() : traits_type::to_int_type(*gptr());
+	}
+
+private:
+	const ArchiveMember & member;
+	ArchiveStreams & streams;
+	unsigned long long remaining;
+	std::ifstream file;
+	std::unique_ptr<Inflater> inflater;
+	std::unique_ptr<ArchiveStream> archiveStream;
+	std::streambuf * source = nullptr;
+	std::vector<char> buffer = std::vector<char>(65536);
+};
+
+// Input stream of the data of an archive member, the errors reading the archive are thrown
+class MemberStream : public std::istream {
+public:
+	MemberStream(const ArchiveMember & member, ArchiveStreams & streams) :
+		std::istream{ nullptr }, buffer{ member, streams } {
+		rdbuf(&buffer);
+		exceptions(std::ios_base::badbit);
+	}
+
+private:
+	MemberBuffer buffer;
+};
+
+// Listing of a directory saved by the incremental scan, valid as long as the directory isn't modified
+struct DirectoryListing {
+	// modification time of the directory (0 if it must be listed again)
+	long long time = 0;
+	// regular files ('f') and subdirectories ('d') followed by their name, in iteration order
+	std::vector<std::string> entries;
+};
+
+const std::string s_scanCacheHeader = "bin2cpp scan cache 1";
+
+// Load the directory listings saved by saveScanCache() (empty if the file doesn't exist or has another format)
+std::map<std::string, DirectoryListing> loadScanCache(const fs::path & fileName) {
+	std::map<std::string, DirectoryListing> listings;
+	std::ifstream stream{ fileName, std::ios_base::in | std::ios_base::binary };
+	std::string line;
+	if (!stream || !std::getline(stream, line) || line != s_scanCacheHeader) {
+		return listings;
+	}
+	// "<time> <entry count> <directory>" followed by the entries, one per line
+	while (std::getline(stream, line)) {
+		std::istringstream header{ line };
+		DirectoryListing listing;
+		size_t entryCount = 0;
+		std::string directory;
+		if (!(header >> listing.time >> entryCount) || !std::getline(header.ignore(1), directory)) {
+			listings.clear();
+			break;
+		}
+		for (size_t i = 0; i < entryCount && std::getline(stream, line); ++i) {
+			listing.entries.push_back(line);
+		}
+		listings[directory] = std::move(listing);
+	}
+	return listings;
+}
+
+void saveScanCache(const fs::path & fileName, const std::map<std::string, DirectoryListing> & listings) {
+	std::ostringstream stream;
+	stream << s_scanCacheHeader << "\n";
+	for (const auto & listing : listings) {
+		stream << listing.second.time << " " << listing.second.entries.size() << " " << listing.first << "\n";
+		for (const auto & entry : listing.second.entries) {
+			stream << entry << "\n";
+		}
+	}
+	writeFile(fileName, stream.str());
+}
+
+// Add the regular files of a directory and of its subdirectories, in the order of recursive_directory_iterator.
+// Only the directories modified since the saved listings are listed, the others are only checked with a stat.
+void scanDirectory(const fs::path & directory, std::map<std::string, DirectoryListing> & listings, std::set<std::string> & scanned,
+	long long recentTime, std::vector<std::string> & files) {
+	const std::string key = directory.generic_string();
+	const long long time = static_cast<long long>(fs::last_write_time(directory).time_since_epoch().count());
+	scanned.insert(key);
+
+	// the references to the elements of a map stay valid while the subdirectories are added
+	DirectoryListing & listing = listings[key];
+	if (listing.time != time || time == 0) {
+		listing.entries.clear();
+		for (auto entry : fs::directory_iterator{ directory }) {
+			const fs::path path = entry.path();
+			// the symbolic links to directories aren't followed, as with recursive_directory_iterator
+			if (fs::is_directory(fs::symlink_status(path))) {
+				listing.entries.push_back("d" + path.filename().generic_string());
+			}
+			else if (fs::is_regular_file(path)) {
+				listing.entries.push_back("f" + path.filename().generic_string());
+			}
+		}
+		// a directory modified again within the resolution of its time stamp would look unchanged next time
+		listing.time = time < recentTime ? time : 0;
+	}
+
+	for (const auto & entry : listing.entries) {
+		const fs::path path = directory / entry.substr(1);
+		if (entry[0] == 'd') {
+			scanDirectory(path, listings, scanned, recentTime, files);
+		}
+		else {
+			files.push_back(path.generic_string());
+		}
+	}
+}
+
+// Representations of the data supported by a compiler
+struct CompilerCapabilities {
+	// #embed directive
+	bool embed;
+	// maximum size in bytes of a string literal (including the terminating null character)
+	size_t maxStringSize;
+};
+
+// Default capabilities when no compiler is probed: Visual C++ limits the string literals to 65535 bytes
+const CompilerCapabilities s_portableCapabilities{ false, 65535 };
+
+// Run the compiler command on the given source code, returns true if it's accepted
+bool compileProbe(const std::string & command, const std::string & source, const fs::path & workFile) {
+	const fs::path sourceFile = workFile.generic_string() + ".cpp";
+	const fs::path logFile = workFile.generic_string() + ".log";
+	writeFile(sourceFile, source);
+	const std::string commandLine = command + " \"" + sourceFile.generic_string() + "\" > \"" + logFile.generic_string() + "\" 2>&1";
+	const int status = std::system(commandLine.c_str());
+	fs::remove(sourceFile);
+	fs::remove(logFile);
+	return status == 0;
+}
+
+std::string stringLiteralProbe(size_t size) {
+	std::string source = "const char data[" + std::to_string(size) + "] =";
+	for (size_t i = 0; i + 1 < size; i += 1000) {
+		source += "\n\"" + std::string(std::min<size_t>(1000, size - 1 - i), 'a') + "\"";
+	}
+	return source + ";\n";
+}
+
+// Probe which representations of the data the compiler command supports
+CompilerCapabilities probeCompiler(const std::string & command, const fs::path & workDir) {
+	const fs::path workFile = workDir / ".bin2cpp-probe";
+	CompilerCapabilities capabilities{ false, 0 };
+
+	const fs::path embedFile = fs::absolute(workDir / ".bin2cpp-probe.bin");
+	writeFile(embedFile, "abc");
+	capabilities.embed = compileProbe(command,
+		"const unsigned char data[] = {\n#embed \"" + embedFile.generic_string() + "\"\n};\n"
+		"static_assert(sizeof(data) == 3, \"#embed\");\n", workFile);
+	fs::remove(embedFile);
+
+	for (size_t size : { size_t{ 1 } << 24, s_portableCapabilities.maxStringSize }) {
+		if (compileProbe(command, stringLiteralProbe(size), workFile)) {
+			capabilities.maxStringSize = size;
+			break;
+		}
+	}
+	return capabilities;
+}
+
+} // anonymous namespace
+
+struct Generator::Impl {
+	explicit Impl(unsigned int threadCount) : pool{ threadCount } {
+	}
+
+	bool findCachedTransform(unsigned long long key, std::string & data) {
+		std::lock_guard<std::mutex> lock{ cacheMutex };
+		const auto it = transformCache.find(key);
+		if (it == transformCache.end()) {
+			return false;
+		}
+		data = it->second;
+		return true;
+	}
+
+	void cacheTransform(unsigned long long key, const std::string & data) {
+		std::lock_guard<std::mutex> lock{ cacheMutex };
+		transformCache[key] = data;
+	}
+
+	// capabilities of the compiler, probed once per command
+	CompilerCapabilities compilerCapabilities(const std::string & command, const fs::path & workDir) {
+		if (command.empty()) {
+			return s_portableCapabilities;
+		}
+		std::lock_guard<std::mutex> lock{ cacheMutex };
+		const auto it = compilers.find(command);
+		if (it != compilers.end()) {
+			return it->second;
+		}
+		return compilers.emplace(command, probeCompiler(command, workDir)).first->second;
+	}
+
+	ThreadPool pool;
+	// transform results by hash of the input data and of the transform chain
+	std::mutex cacheMutex;
+	std::map<unsigned long long, std::string> transformCache;
+	std::map<std::string, CompilerCapabilities> compilers;
+	// decompressions of the .tar.gz inputs, between the members read from them
+	ArchiveStreams archiveStreams;
+};
+
+namespace /* anonymous */ {
+
+// Maximum size of the embedded files, FileInfo::fileDataSize being 32-bit
+const unsigned long long s_maxFileSize = 0xFFFFFFFF;
+
+// Size of the data of an input file, before the transforms
+unsigned long long inputFileSize(const Options & options, const std::string & path) {
+	const auto member = options.archiveMembers.find(path);
+	return member != options.archiveMembers.end() ? member->second.size : fs::file_size(path);
+}
+
+// Open the data of an input file, streamed from its archive if it's an archive member
+std::unique_ptr<std::istream> openInputFile(const Options & options, Generator::Impl & generator, const std::string & path) {
+	const auto member = options.archiveMembers.find(path);
+	if (member != options.archiveMembers.end()) {
+		return std::unique_ptr<std::istream>{ new MemberStream{ member->second, generator.archiveStreams } };
+	}
+	std::unique_ptr<std::istream> file{ new std::ifstream{ path, std::ios_base::in | std::ios_base::binary } };
+	if (!*file) {
+		throw std::runtime_error{ "Failed to open file " + path };
+	}
+	return file;
+}
+
+// Read the whole data of an input file (only for the files processed in memory: transformed, constexpr...)
+std::string readInputFile(const Options & options, Generator::Impl & generator, const std::string & path) {
+	if (!options.archiveMembers.count(path)) {
+		return readFile(path);
+	}
+	std::string data(static_cast<size_t>(inputFileSize(options, path)), '\0');
+	if (!data.empty() && !openInputFile(options, generator, path)->read(&data[0], static_cast<std::streamsize>(data.size()))) {
+		throw std::runtime_error{ "Failed to read " + path };
+	}
+	return data;
+}
+
+// Apply the matching transforms to the input files (in parallel), return the transformed data by file name
+std::map<std::string, std::string> transformFiles(const Options & options, Generator::Impl & generator, const Progress & progress) {
+	std::vector<std::pair<std::string, std::vector<std::string>>> jobs;
+	for (auto path : options.inputFiles) {
+		std::vector<std::string> chain;
+		for (auto rule : options.transforms) {
+			if (matchGlob(rule.pattern, path)) {
+				chain.push_back(rule.transform);
+			}
+		}
+		if (!chain.empty()) {
+			jobs.emplace_back(path, chain);
+		}
+	}
+
+	std::map<std::string, std::string> results;
+	if (jobs.empty()) {
+		return results;
+	}
+	notify(progress.onMessage, "Transforming " + std::to_string(jobs.size()) + " file(s)...");
+
+	std::mutex mutex;
+	std::string error;
+	std::atomic<unsigned int> transformedCount{ 0 };
+	generator.pool.parallelFor(jobs.size(), [&](size_t i, unsigned int workerId) {
+		const auto & path = jobs[i].first;
+		const auto & chain = jobs[i].second;
+		try {
+			std::string data = readInputFile(options, generator, path);
+
+			// the cache key covers the input data and the whole transform chain
+			unsigned long long key = hashData(data);
+			for (auto transform : chain) {
+				key = hashData(transform + '\0', key);
+			}
+			std::ostringstream cacheName;
+			cacheName << std::hex << key << ".bin";
+			const fs::path cacheFile = options.cacheDir / cacheName.str();
+
+			if (generator.findCachedTransform(key, data)) {
+				// already transformed by a previous generation
+			}
+			else if (!options.cacheDir.empty() && fs::is_regular_file(cacheFile)) {
+				data = readFile(cacheFile);
+				generator.cacheTransform(key, data);
+			}
+			else {
+				// scratch files for the external commands
+				const fs::path workFile = options.workDir / (".bin2cpp-transform-" + std::to_string(workerId));
+				for (auto transform : chain) {
+					data = applyTransform(transform, data, workFile);
+				}
+				if (!options.cacheDir.empty()) {
+					writeCacheFile(cacheFile, data);
+				}
+				generator.cacheTransform(key, data);
+				++transformedCount;
+			}
+
+			std::lock_guard<std::mutex> lock{ mutex };
+			results[path] = std::move(data);
+		}
+		catch (const std::exception & e) {
+			std::lock_guard<std::mutex> lock{ mutex };
+			if (error.empty()) {
+				error = path + ": " + e.what();
+			}
+		}
+	});
+
+	if (!error.empty()) {
+		throw std::runtime_error{ "Failed to transform " + error };
+	}
+	notify(progress.onMessage, std::to_string(transformedCount) + " file(s) transformed, " + std::to_string(jobs.size() - transformedCount) + " from the cache.");
+	return results;
+}
+
+// Quote and escape a string to be used as a C++ string literal
+std::string cppStringLiteral(const std::string & value) {
+	std::string result = "\"";
+	for (char c : value) {
+		if (c == '"' || c == '\\') {
+			result += '\\';
+		}
+		result += c;
+	}
+	return result + "\"";
+}
+
+// Hash and CRCs of the data computed while writing it
+class DataDigest {
+public:
+	DataDigest(unsigned long long dataSize, unsigned int crcBlockSize) :
+		hash{ hashData(std::string{}) }, dataSize{ dataSize }, crcBlockSize{ crcBlockSize } {
+	}
+
+	void update(unsigned char c) {
+		hash = (hash ^ c) * 1099511628211ULL;
+		updateCrc(c);
+	}
+
+	// Same as calling update(0) for each byte, without a loop over the bytes of a large hole
+	void updateZeros(unsigned long long size) {
+		// xor with 0 doesn't change the hash, so it's only multiplied by the prime power size
+		unsigned long long factor = 1099511628211ULL;
+		for (unsigned long long n = size; n != 0; n >>= 1) {
+			if (n & 1) {
+				hash *= factor;
+			}
+			factor *= factor;
+		}
+		if (crcBlockSize == 0) {
+			count += size;
+			return;
+		}
+		while (size > 0) {
+			if (count % crcBlockSize == 0 && size >= crcBlockSize) {
+				// the CRC of a whole block of zeros is always the same
+				if (!zeroBlockCrcComputed) {
+					unsigned int value = 0xFFFFFFFF;
+					for (unsigned int i = 0; i < crcBlockSize; ++i) {
+						value = crc32cTable()[value & 0xFF] ^ (value >> 8);
+					}
+					zeroBlockCrc = ~value;
+					zeroBlockCrcComputed = true;
+				}
+				blockCrcs.push_back(zeroBlockCrc);
+				count += crcBlockSize;
+				size -= crcBlockSize;
+			}
+			else {
+				updateCrc(0);
+				size -= 1;
+			}
+		}
+	}
+
+	// see hashData
+	unsigned long long hash;
+	// CRC32C of each block of the data (if a block size is given)
+	std::vector<unsigned int> blockCrcs;
+
+private:
+	void updateCrc(unsigned char c) {
+		count += 1;
+		if (crcBlockSize != 0) {
+			crc = crc32cTable()[(crc ^ c) & 0xFF] ^ (crc >> 8);
+			if (count % crcBlockSize == 0 || count == dataSize) {
+				blockCrcs.push_back(~crc);
+				crc = 0xFFFFFFFF;
+			}
+		}
+	}
+
+	unsigned long long dataSize;
+	unsigned int crcBlockSize;
+	unsigned long long count = 0;
+	unsigned int crc = 0xFFFFFFFF;
+	unsigned int zeroBlockCrc = 0;
+	bool zeroBlockCrcComputed = false;
+};
+
+// Adds the data written to the progress counters (if any), by chunks so the workers don't contend on them for each byte
+class DataCounter {
+public:
+	explicit DataCounter(ProgressCounters * counters) :
+		counters{ counters } {
+	}
+
+	~DataCounter() {
+		flush();
+	}
+
+	void add(unsigned long long size) {
+		pending += size;
+		if (pending >= 1024 * 1024) {
+			flush();
+		}
+	}
+
+	// the whole data of a file is written
+	void fileDone() {
+		flush();
+		if (counters) {
+			counters->filesDone.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+private:
+	void flush() {
+		if (counters && pending > 0) {
+			counters->bytesDone.fetch_add(pending, std::memory_order_relaxed);
+		}
+		pending = 0;
+	}
+
+	ProgressCounters * counters;
+	unsigned long long pending = 0;
+};
+
+// A range of a file, either stored on the disk or a hole reading as zeros
+struct DataSegment {
+	unsigned long long offset;
+	unsigned long long size;
+	bool hole;
+};
+
+// List the data and holes of a sparse file, a single data segment if the system doesn't tell
+std::vector<DataSegment> listDataSegments(const std::string & fileName, unsigned long long fileSize) {
+	const std::vector<DataSegment> wholeFile{ DataSegment{ 0, fileSize, false } };
+	// offset and size of the ranges stored on the disk
+	std::vector<std::pair<unsigned long long, unsigned long long>> ranges;
+#ifdef _WIN32
+	const HANDLE file = ::CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return wholeFile;
+	}
+	FILE_ALLOCATED_RANGE_BUFFER query{};
+	query.Length.QuadPart = fileSize;
+	FILE_ALLOCATED_RANGE_BUFFER found[64];
+	for (;;) {
+		DWORD bytes = 0;
+		const BOOL done = ::DeviceIoControl(file, FSCTL_QUERY_ALLOCATED_RANGES, &query, sizeof(query), found, sizeof(found), &bytes, nullptr);
+		if (!done && ::GetLastError() != ERROR_MORE_DATA) {
+			// not supported by the file system
+			::CloseHandle(file);
+			return wholeFile;
+		}
+		const DWORD count = bytes / sizeof(found[0]);
+		for (DWORD i = 0; i < count; ++i) {
+			ranges.emplace_back(found[i].FileOffset.QuadPart, found[i].Length.QuadPart);
+		}
+		if (done || count == 0) {
+			break;
+		}
+		// query again after the last range returned
+		const LONGLONG next = found[count - 1].FileOffset.QuadPart + found[count - 1].Length.QuadPart;
+		query.Length.QuadPart -= next - query.FileOffset.QuadPart;
+		query.FileOffset.QuadPart = next;
+	}
+	::CloseHandle(file);
+#elif defined(SEEK_DATA) && defined(SEEK_HOLE)
+	const int fd = ::open(fileName.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return wholeFile;
+	}
+	bool supported = true;
+	off_t offset = 0;
+	while (offset < static_cast<off_t>(fileSize)) {
+		const off_t data = ::lseek(fd, offset, SEEK_DATA);
+		if (data < 0) {
+			// ENXIO: no more data up to the end of the file, otherwise holes aren't supported here
+			supported = errno == ENXIO;
+			break;
+		}
+		off_t hole = ::lseek(fd, data, SEEK_HOLE);
+		if (hole < 0) {
+			hole = fileSize;
+		}
+		ranges.emplace_back(data, hole - data);
+		offset = hole;
+	}
+	::close(fd);
+	if (!supported) {
+		return wholeFile;
+	}
+#else
+	(void)fileName;
+	return wholeFile;
+#endif
+
+	// the holes are what is between the ranges, the file may have grown since its size was read
+	std::vector<DataSegment> segments;
+	unsigned long long position = 0;
+	for (const auto & range : ranges) {
+		const unsigned long long begin = std::min<unsigned long long>(range.first, fileSize);
+		const unsigned long long end = std::min<unsigned long long>(range.first + range.second, fileSize);
+		if (begin > position) {
+			segments.push_back(DataSegment{ position, begin - position, true });
+		}
+		if (end > begin) {
+			segments.push_back(DataSegment{ begin, end - begin, false });
+			position = end;
+		}
+	}
+	if (position < fileSize) {
+		segments.push_back(DataSegment{ position, fileSize - position, true });
+	}
+	return segments;
+}
+
+// The size of the array is already written: a file truncated while it's read can't be embedded
+void checkSegmentRead(unsigned long long readSize, const DataSegment & segment) {
+	if (readSize < segment.size) {
+		throw std::runtime_error{ "Input data shorter than expected at offset " + std::to_string(segment.offset + readSize) + " (modified during the generation?)" };
+	}
+}
+
+void writeHexData(std::istream & inputFile, const std::vector<DataSegment> & segments, DataDigest & digest, DataCounter & counter, std::ostream & stream) {
+	// save formatting flags of the given stream
+	std::ios::fmtflags flags(stream.flags());
+
+	size_t char_count{ 0 };
+	char c;
+	for (size_t i = 0; i < segments.size(); ++i) {
+		const DataSegment & segment = segments[i];
+		if (!segment.hole) {
+			unsigned long long n = 0;
+			for (; n < segment.size && inputFile.get(c); ++n) {
+				if (char_count % 20 == 0) {
+					stream << "\n\t\t";
+				}
+				char_count += 1;
+				digest.update(static_cast<unsigned char>(c));
+				counter.add(1);
+
+				stream << "0x" << std::hex << (static_cast<int>(c) & 0xFF) << ",";
+			}
+			checkSegmentRead(n, segment);
+			continue;
+		}
+		// holes aren't read, and the remaining elements of the array are zero initialized
+		digest.updateZeros(segment.size);
+		counter.add(segment.size);
+		inputFile.seekg(segment.offset + segment.size);
+		if (i + 1 == segments.size()) {
+			break;
+		}
+		// the inner holes are written as "0," (instead of "0x0,")
+		static const std::string s_zeros = [] {
+			std::string line = "\n\t\t";
+			for (int n = 0; n < 20; ++n) {
+				line += "0,";
+			}
+			return line;
+		}();
+		unsigned long long remaining = segment.size;
+		while (remaining > 0) {
+			// 20 elements per line, as for the bytes read, written a line at a time
+			const size_t column = char_count % 20;
+			const unsigned int count = static_cast<unsigned int>(std::min<unsigned long long>(remaining, 20 - column));
+			const size_t begin = column == 0 ? 0 : 3 + 2 * column;
+			stream.write(s_zeros.data() + begin, static_cast<std::streamsize>(3 + 2 * (column + count) - begin));
+			char_count += count;
+			remaining -= count;
+		}
+	}
+
+	stream << "\n\t";
+
+	// restore save formatting flags
+	stream.flags(flags);
+}
+
+void writeStringData(std::istream & inputFile, const std::vector<DataSegment> & segments, DataDigest & digest, DataCounter & counter, std::ostream & stream) {
+	static const char * s_octalDigits = "01234567";
+
+	// split the literal in pieces to stay below the per literal limits
+	size_t char_count{ 0 };
+	char c;
+	stream << "\n\t\t\"";
+	for (size_t i = 0; i < segments.size(); ++i) {
+		const DataSegment & segment = segments[i];
+		if (!segment.hole) {
+			unsigned long long n = 0;
+			for (; n < segment.size && inputFile.get(c); ++n) {
+				if (char_count > 0 && char_count % 1000 == 0) {
+					stream << "\"\n\t\t\"";
+				}
+				char_count += 1;
+				const unsigned char value = static_cast<unsigned char>(c);
+				digest.update(value);
+				counter.add(1);
+
+				if (value == '"' || value == '\\' || value == '?') {
+					// '?' is escaped to avoid trigraphs
+					stream << '\\' << c;
+				}
+				else if (value >= 0x20 && value < 0x7F) {
+					stream << c;
+				}
+				else {
+					// always 3 octal digits, so a following digit isn't part of the escape sequence
+					stream << '\\' << s_octalDigits[value >> 6] << s_octalDigits[(value >> 3) & 7] << s_octalDigits[value & 7];
+				}
+			}
+			checkSegmentRead(n, segment);
+			continue;
+		}
+		// holes aren't read, and the array is zero filled after the end of the literal
+		digest.updateZeros(segment.size);
+		counter.add(segment.size);
+		inputFile.seekg(segment.offset + segment.size);
+		if (i + 1 == segments.size()) {
+			break;
+		}
+		// the inner holes are written as "\0", but for their last byte: a following digit isn't part of the escape sequence
+		static const std::string s_zeros = [] {
+			std::string piece;
+			for (int n = 0; n < 1000; ++n) {
+				piece += "\\0";
+			}
+			return piece;
+		}();
+		unsigned long long remaining = segment.size;
+		while (remaining > 0) {
+			if (char_count > 0 && char_count % 1000 == 0) {
+				stream << "\"\n\t\t\"";
+			}
+			const unsigned int count = static_cast<unsigned int>(std::min<unsigned long long>(remaining, 1000 - char_count % 1000));
+			const bool last = count == remaining;
+			stream.write(s_zeros.data(), 2 * static_cast<std::streamsize>(count - (last ? 1 : 0)));
+			if (last) {
+				stream << "\\000";
+			}
+			char_count += count;
+			remaining -= count;
+		}
+	}
+	stream << "\"";
+}
+
+// How the data of a file is written
+struct DataFormat {
+	// "hex", "string" or "embed"
+	std::string encoding;
+	// external linkage, for the data written in the shards
+	bool exported;
+	// the digest is always computed while writing the data, except for "embed" if not needed
+	bool digestNeeded;
+	unsigned int crcBlockSize;
+};
+
+// Write the data as a C++ array with the given encoding ("hex" or "string"), the holes aren't read
+DataDigest convertDataToCppSource(const std::string & fileId, std::istream & inputFile, unsigned long long fileLen, const std::vector<DataSegment> & segments, const DataFormat & format, ProgressCounters * counters, std::ostream & stream) {
+	DataDigest digest{ fileLen, format.crcBlockSize };
+	DataCounter counter{ counters };
+	const std::string linkage = format.exported ? "extern " : "";
+	stream << "\t// encoding: " << format.encoding << "\n";
+	stream << "\tconst unsigned int " << fileId << "_data_size = " << fileLen << ";\n";
+	if (format.encoding == "string") {
+		// the array must have room for the terminating null character of the literal
+		stream << "\t" << linkage << "const unsigned char " << fileId << "_data[" << fileId << "_data_size + 1] =";
+		writeStringData(inputFile, segments, digest, counter, stream);
+		stream << ";\n";
+	}
+	else {
+		stream << "\t" << linkage << "const unsigned char " << fileId << "_data[" << fileId << "_data_size] = {";
+		writeHexData(inputFile, segments, digest, counter, stream);
+		stream << "};\n";
+	}
+	counter.fileDone();
+	return digest;
+}
+
+DataDigest convertDataToCppSource(const std::string & fileId, std::istream & inputFile, unsigned long long fileLen, const DataFormat & format, ProgressCounters * counters, std::ostream & stream) {
+	return convertDataToCppSource(fileId, inputFile, fileLen, std::vector<DataSegment>{ DataSegment{ 0, fileLen, false } }, format, counters, stream);
+}
+
+// Path of a file relative to a directory, both made absolute (the absolute path if they're on different roots)
+std::string relativePath(const fs::path & path, const fs::path & directory) {
+	const fs::path absolutePath = fs::absolute(path);
+	const fs::path absoluteDirectory = fs::absolute(directory);
+	if (absolutePath.root_name() != absoluteDirectory.root_name()) {
+		return absolutePath.generic_string();
+	}
+	auto components = [](const fs::path & absolute) {
+		std::vector<std::string> names;
+		std::istringstream stream{ absolute.relative_path().generic_string() };
+		for (std::string name; std::getline(stream, name, '/');) {
+			if (name == "..") {
+				if (!names.empty()) {
+					names.pop_back();
+				}
+			}
+			else if (!name.empty() && name != ".") {
+				names.push_back(name);
+			}
+		}
+		return names;
+	};
+	const std::vector<std::string> pathNames = components(absolutePath);
+	const std::vector<std::string> directoryNames = components(absoluteDirectory);
+	size_t common = 0;
+	while (common < pathNames.size() && common < directoryNames.size() && pathNames[common] == directoryNames[common]) {
+		++common;
+	}
+	std::string relative;
+	for (size_t i = common; i < directoryNames.size(); ++i) {
+		relative += "../";
+	}
+	for (size_t i = common; i < pathNames.size(); ++i) {
+		relative += pathNames[i] + (i + 1 < pathNames.size() ? "/" : "");
+	}
+	return relative;
+}
+
+DataDigest convertFileDataToCppSource(const std::string & fileName, const std::string & fileId, const DataFormat & format, const fs::path & embedDirectory, ProgressCounters * counters, std::ostream & stream) {
+	assert(fs::is_regular_file(fileName));
+
+	std::ifstream inputFile{ fileName, std::ios_base::in | std::ios_base::binary };
+	if (!inputFile) {
+		throw std::runtime_error{std::string("Failed to open file ") + fileName};
+	}
+	const unsigned long long fileSize = fs::file_size(fileName);
+	const std::vector<DataSegment> segments = listDataSegments(fileName, fileSize);
+
+	if (format.encoding == "embed") {
+		// the compiler reads the file, it's only read here if its digest is needed
+		DataDigest digest{ fileSize, format.crcBlockSize };
+		if (format.digestNeeded) {
+			char c;
+			for (const DataSegment & segment : segments) {
+				if (segment.hole) {
+					digest.updateZeros(segment.size);
+					inputFile.seekg(segment.offset + segment.size);
+					continue;
+				}
+				unsigned long long n = 0;
+				for (; n < segment.size && inputFile.get(c); ++n) {
+					digest.update(static_cast<unsigned char>(c));
+				}
+				checkSegmentRead(n, segment);
+			}
+		}
+		stream << "\t// encoding: embed\n";
+		stream << "\tconst unsigned int " << fileId << "_data_size = " << fileSize << ";\n";
+		stream << "\t" << (format.exported ? "extern " : "") << "const unsigned char " << fileId << "_data[" << fileId << "_data_size] = {\n";
+		const std::string embedPath = embedDirectory.empty() ? fs::absolute(fileName).generic_string() : relativePath(fileName, embedDirectory);
+		stream << "#embed " << cppStringLiteral(embedPath) << "\n";
+		stream << "\t};\n";
+		DataCounter counter{ counters };
+		counter.add(fileSize);
+		counter.fileDone();
+		return digest;
+	}
+	return convertDataToCppSource(fileId, inputFile, fileSize, segments, format, counters, stream);
+}
+
+// Choose how to write the data of a file
+// (onDisk: the data is the content of the input file, not transformed nor read from an archive)
+std::string selectEncoding(const Options & options, const CompilerCapabilities & compiler, size_t dataSize, bool onDisk) {
+	std::string encoding = options.encoding;
+	if (encoding == "auto") {
+		// #embed doesn't parse anything, a string literal is a single token, an array has a token per byte
+		if (compiler.embed && onDisk && dataSize > 0) {
+			return "embed";
+		}
+		return dataSize < compiler.maxStringSize ? "string" : "hex";
+	}
+	if (encoding == "embed" && (!onDisk || dataSize == 0)) {
+		// #embed reads the file on the disk, and can't produce an empty array
+		return "hex";
+	}
+	return encoding;
+}
+
+// Header declaring the registry, shared by all the bundles: with a module, it's not attached to the module
+std::string registryHeaderFileName(const Options & options) {
+	return fs::path{ options.headerFileName }.stem().generic_string() + "_registry.h";
+}
+
+void writeRegistryDeclarations(std::ostream & stream) {
+	// shared by all the bundles generated with -register, the first included header defines it
+	static const char * s_registryHeaderContent = R"raw(
+#ifndef BIN2CPP_REGISTRY
+#define BIN2CPP_REGISTRY
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+// Registry of the bundles generated with -register, collected by the linker in a section (without dynamic initializer).
+// A registry merges the bundles linked in the same module (executable or shared library).
+namespace bin2cpp {
+	struct RegisteredBundle {
+		// namespace of the bundle
+		const char * name;
+		size_t fileCount;
+		// name, data and size of a file of the bundle
+		void (*getFile)(size_t index, std::string & name, const char * & data, size_t & size);
+	};
+
+	struct RegisteredFile {
+		const RegisteredBundle * bundle;
+		const char * data;
+		size_t size;
+	};
+}
+
+#if defined(_MSC_VER)
+#pragma section("bin2cpp$a", read)
+#pragma section("bin2cpp$m", read)
+#pragma section("bin2cpp$z", read)
+#define BIN2CPP_REGISTRY_ENTRY __declspec(allocate("bin2cpp$m"))
+#define BIN2CPP_REGISTRY_LOCAL
+// nothing references the entries: the linker is told to keep them (/OPT:REF), the C names being decorated on x86
+#if defined(_M_IX86)
+#define BIN2CPP_REGISTRY_KEEP(name) __pragma(comment(linker, "/include:_" #name))
+#else
+#define BIN2CPP_REGISTRY_KEEP(name) __pragma(comment(linker, "/include:" #name))
+#endif
+namespace bin2cpp {
+	namespace registry {
+		// the linker sorts the sections by name: the entries are between these markers
+		extern __declspec(allocate("bin2cpp$a")) __declspec(selectany) const RegisteredBundle * const sectionBegin = nullptr;
+		extern __declspec(allocate("bin2cpp$z")) __declspec(selectany) const RegisteredBundle * const sectionEnd = nullptr;
+		inline const RegisteredBundle * const * begin() {
+			return &sectionBegin + 1;
+		}
+		inline const RegisteredBundle * const * end() {
+			return &sectionEnd;
+		}
+	}
+}
+#elif defined(__APPLE__)
+#define BIN2CPP_REGISTRY_ENTRY __attribute__((used, section("__DATA,bin2cpp_bundles")))
+#define BIN2CPP_REGISTRY_LOCAL __attribute__((visibility("hidden")))
+#define BIN2CPP_REGISTRY_KEEP(name)
+extern const bin2cpp::RegisteredBundle * const bin2cppBundlesBegin[] __asm("section$start$__DATA$bin2cpp_bundles");
+extern const bin2cpp::RegisteredBundle * const bin2cppBundlesEnd[] __asm("section$end$__DATA$bin2cpp_bundles");
+namespace bin2cpp {
+	namespace registry {
+		inline const RegisteredBundle * const * begin() {
+			return bin2cppBundlesBegin;
+		}
+		inline const RegisteredBundle * const * end() {
+			return bin2cppBundlesEnd;
+		}
+	}
+}
+#else
+#define BIN2CPP_REGISTRY_ENTRY __attribute__((used, section("bin2cpp_bundles")))
+#define BIN2CPP_REGISTRY_LOCAL __attribute__((visibility("hidden")))
+#define BIN2CPP_REGISTRY_KEEP(name)
+// defined by the linker for the sections named as C identifiers (local to each module)
+extern "C" const bin2cpp::RegisteredBundle * const __start_bin2cpp_bundles[] __attribute__((weak, visibility("hidden")));
+extern "C" const bin2cpp::RegisteredBundle * const __stop_bin2cpp_bundles[] __attribute__((weak, visibility("hidden")));
+namespace bin2cpp {
+	namespace registry {
+		inline const RegisteredBundle * const * begin() {
+			return __start_bin2cpp_bundles;
+		}
+		inline const RegisteredBundle * const * end() {
+			return __stop_bin2cpp_bundles;
+		}
+	}
+}
+#endif
+
+namespace bin2cpp {
+	namespace registry {
+		struct Index {
+			std::vector<const RegisteredBundle *> bundles;
+			std::unordered_map<std::string, RegisteredFile> files;
+		};
+
+		// built on the first lookup, the files of the first bundles (in link order) hide the files of the same name
+		BIN2CPP_REGISTRY_LOCAL inline const Index & index() {
+			static const Index merged = []() {
+				Index index;
+				for (auto entry = registry::begin(); entry != registry::end(); ++entry) {
+					// the linker may pad the section with zeros
+					if (*entry != nullptr) {
+						index.bundles.push_back(*entry);
+					}
+				}
+				for (auto bundle : index.bundles) {
+					for (size_t i = 0; i < bundle->fileCount; ++i) {
+						std::string name;
+						RegisteredFile file{ bundle, nullptr, 0 };
+						bundle->getFile(i, name, file.data, file.size);
+						index.files.emplace(std::move(name), file);
+					}
+				}
+				return index;
+			}();
+			return merged;
+		}
+	}
+
+	// Bundles of the module
+	BIN2CPP_REGISTRY_LOCAL inline const std::vector<const RegisteredBundle *> & registeredBundles() {
+		return registry::index().bundles;
+	}
+
+	// Find a file in all the bundles of the module (hash lookup). Returns nullptr if not found.
+	BIN2CPP_REGISTRY_LOCAL inline const RegisteredFile * findRegisteredFile(const std::string & name) {
+		const auto & files = registry::index().files;
+		const auto it = files.find(name);
+		return it != files.end() ? &it->second : nullptr;
+	}
+}
+
+#endif
+)raw";
+
+	stream << s_registryHeaderContent;
+}
+
+// Write the includes of the generated API, in the header or in the global module fragment of the module units
+void writeApiIncludes(const Options & options, std::ostream & stream) {
+	stream << "#include <string>\n";
+	stream << "#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)\n";
+	stream << "#if defined(__has_include)\n";
+	stream << "#if __has_include(<memory_resource>)\n";
+	stream << "#include <memory_resource>\n";
+	stream << "#endif\n";
+	stream << "#endif\n";
+	stream << "#endif\n";
+	if (options.generateAsyncApi || options.generateSharedCache || options.generateLazyDecode) {
+		stream << "#include <functional>\n";
+	}
+	if (options.generateAsyncApi) {
+		stream << "#include <exception>\n";
+		stream << "#include <future>\n";
+		stream << "#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L\n";
+		stream << "#include <coroutine>\n";
+		stream << "#endif\n";
+	}
+	if (options.generateVfs) {
+		stream << "#include <unordered_map>\n";
+		stream << "#include <vector>\n";
+	}
+	if (options.registerBundle && !options.moduleName.empty()) {
+		stream << "\n";
+		stream << "#include \"" << registryHeaderFileName(options) << "\"\n";
+	}
+	else if (options.registerBundle) {
+		writeRegistryDeclarations(stream);
+	}
+}
+
+// Write the declarations of the generated API, in the header or in the purview of the module interface unit
+void writeApiDeclarations(const Options & options, std::ostream & stream) {
+	// with front-coded names, FileInfo::fileName is null for the embedded files and name() decodes it from the name table
+	static const char * s_headerFrontCodedNames = R"raw(
+	struct FileInfo;
+	std::string decodeFileName(const FileInfo & file);
+)raw";
+
+	// with -crc, the content accessors of FileInfo verify the blocks they read
+	static const char * s_headerCheckedContentDeclarations = R"raw(
+	struct FileInfo;
+	// Verify the blocks of an embedded file covering the given range, throws std::runtime_error if one of them is corrupted
+	// (the files from elsewhere aren't verified)
+	void checkContent(const FileInfo & file, size_t offset, size_t size);
+)raw";
+
+	static const char * s_headerFileInfo = R"raw(
+	struct FileInfo {
+		const char * fileName;
+		const char * fileData;
+		const unsigned int fileDataSize;
+		// position in fileInfoList (kept by the copies), noFileIndex for the files from elsewhere (pack, disk...),
+		// checked by embeddedIndex()
+		const unsigned int fileIndex;
+
+		static const unsigned int noFileIndex = 0xFFFFFFFF;
+)raw";
+
+	static const char * s_headerPlainName = R"raw(
+		std::string name() const {
+			return fileName;
+		}
+)raw";
+
+	static const char * s_headerFrontCodedName = R"raw(
+		std::string name() const {
+			return fileName ? fileName : decodeFileName(*this);
+		}
+)raw";
+
+	static const char * s_headerContent = R"raw(
+		std::string content() const {
+			return std::string{ fileData, fileDataSize };
+		}
+		// Content allocated with the given allocator
+		template <typename Allocator, typename = typename Allocator::value_type>
+		std::basic_string<char, std::char_traits<char>, Allocator> content(const Allocator & allocator) const {
+			return std::basic_string<char, std::char_traits<char>, Allocator>(fileData, fileDataSize, allocator);
+		}
+#ifdef __cpp_lib_memory_resource
+		// Content allocated from the given memory resource (an arena for instance)
+		std::pmr::string content(std::pmr::memory_resource * resource) const {
+			return std::pmr::string(fileData, fileDataSize, resource);
+		}
+#endif
+		// Copy the content from the given offset to a buffer, returns the number of bytes copied
+		size_t copyContent(char * buffer, size_t bufferSize, size_t offset = 0) const {
+			if (offset >= fileDataSize) {
+				return 0;
+			}
+			const size_t size = fileDataSize - offset < bufferSize ? fileDataSize - offset : bufferSize;
+			std::char_traits<char>::copy(buffer, fileData + offset, size);
+			return size;
+		}
+)raw";
+
+	static const char * s_headerCheckedContent = R"raw(
+		std::string content() const {
+			checkContent(*this, 0, fileDataSize);
+			return std::string{ fileData, fileDataSize };
+		}
+		// Content allocated with the given allocator
+		template <typename Allocator, typename = typename Allocator::value_type>
+		std::basic_string<char, std::char_traits<char>, Allocator> content(const Allocator & allocator) const {
+			checkContent(*this, 0, fileDataSize);
+			return std::basic_string<char, std::char_traits<char>, Allocator>(fileData, fileDataSize, allocator);
+		}
+#ifdef __cpp_lib_memory_resource
+		// Content allocated from the given memory resource (an arena for instance)
+		std::pmr::string content(std::pmr::memory_resource * resource) const {
+			checkContent(*this, 0, fileDataSize);
+			return std::pmr::string(fileData, fileDataSize, resource);
+		}
+#endif
+		// Copy the content from the given offset to a buffer, returns the number of bytes copied
+		size_t copyContent(char * buffer, size_t bufferSize, size_t offset = 0) const {
+			if (offset >= fileDataSize) {
+				return 0;
+			}
+			const size_t size = fileDataSize - offset < bufferSize ? fileDataSize - offset : bufferSize;
+			checkContent(*this, offset, size);
+			std::char_traits<char>::copy(buffer, fileData + offset, size);
+			return size;
+		}
+)raw";
+
+	static const char * s_headerFileList = R"raw(
+	extern const unsigned int fileInfoListSize;
+	extern const FileInfo fileInfoList[];
+
+	// Position of a file in fileInfoList, or FileInfo::noFileIndex for the files from elsewhere: fileIndex is only
+	// trusted when the file has the data of that entry (a FileInfo built by the caller may have any fileIndex)
+	inline unsigned int embeddedIndex(const FileInfo & file) {
+		if (file.fileIndex >= fileInfoListSize) {
+			return FileInfo::noFileIndex;
+		}
+		const FileInfo & entry = fileInfoList[file.fileIndex];
+		if (entry.fileData != file.fileData || entry.fileDataSize != file.fileDataSize) {
+			return FileInfo::noFileIndex;
+		}
+		return file.fileIndex;
+	}
+
+	struct FileInfoRange {
+		const FileInfo * begin() const {
+			return &fileInfoList[0];
+		}
+		const FileInfo * end() const {
+			return begin() + size();
+		}
+		const size_t size() const {
+			return fileInfoListSize;
+		}
+	};
+
+	inline FileInfoRange fileList() {
+		return FileInfoRange{};
+	}
+
+	// index in fileInfoList of the files sorted by name
+	extern const unsigned int sortedFileIndex[];
+
+	struct SortedFileRange {
+		struct Iterator {
+			const unsigned int * index;
+
+			const FileInfo & operator*() const {
+				return fileInfoList[*index];
+			}
+			Iterator & operator++() {
+				++index;
+				return *this;
+			}
+			bool operator!=(const Iterator & other) const {
+				return index != other.index;
+			}
+		};
+
+		Iterator begin() const {
+			return Iterator{ &sortedFileIndex[0] };
+		}
+		Iterator end() const {
+			return Iterator{ &sortedFileIndex[0] + size() };
+		}
+		size_t size() const {
+			return fileInfoListSize;
+		}
+	};
+
+	// Files sorted by name
+	inline SortedFileRange sortedFileList() {
+		return SortedFileRange{};
+	}
+
+	// Find a file by name (binary search in the sorted names), returns nullptr if not found
+	const FileInfo * findFile(const char * name);
+	inline const FileInfo * findFile(const std::string & name) {
+		return findFile(name.c_str());
+	}
+)raw";
+
+	static const char * s_preloadHeaderContent = R"raw(
+	// Page in the embedded data on a background thread so the first accesses don't stall.
+	// Files of the priority list (or of the default order given with -preload) are processed first.
+	void startPreload();
+	void startPreload(const FileInfo * const * priorityList, size_t count);
+	// Block until the given file has been preloaded (returns immediately if no preload was started)
+	void waitPreloaded(const FileInfo & file);
+)raw";
+
+	static const char * s_normalizedIndexHeaderContent = R"raw(
+	// Find a file by name, ignoring the ASCII case, the kind of separators ('\' or '/'),
+	// the repeated separators and the "./" segments. Returns nullptr if not found.
+	const FileInfo * findFileNormalized(const char * name);
+	inline const FileInfo * findFileNormalized(const std::string & name) {
+		return findFileNormalized(name.c_str());
+	}
+)raw";
+
+	static const char * s_groupHeaderContent = R"raw(
+	// Range of files given by their indexes in fileInfoList
+	struct IndexedFileRange {
+		typedef SortedFileRange::Iterator Iterator;
+
+		const unsigned int * first;
+		const unsigned int * last;
+
+		Iterator begin() const {
+			return Iterator{ first };
+		}
+		Iterator end() const {
+			return Iterator{ last };
+		}
+		size_t size() const {
+			return static_cast<size_t>(last - first);
+		}
+	};
+)raw";
+
+	static const char * s_extensionIndexHeaderContent = R"raw(
+	// Files with the given extension (including the dot, such as ".glsl"), in the embedding order
+	IndexedFileRange filesByExtension(const char * extension);
+	inline IndexedFileRange filesByExtension(const std::string & extension) {
+		return filesByExtension(extension.c_str());
+	}
+)raw";
+
+	static const char * s_tagIndexHeaderContent = R"raw(
+	// Files tagged with the given tag (see -tag), in the embedding order
+	IndexedFileRange filesByTag(const char * tag);
+	inline IndexedFileRange filesByTag(const std::string & tag) {
+		return filesByTag(tag.c_str());
+	}
+)raw";
+
+	static const char * s_contentHashIndexHeaderContent = R"raw(
+	// 64-bit FNV-1a hash of a content, as stored in the content hash index
+	inline unsigned long long hashContent(const char * data, size_t size) {
+		unsigned long long hash = 14695981039346656037ULL;
+		for (size_t i = 0; i < size; ++i) {
+			hash = (hash ^ static_cast<unsigned char>(data[i])) * 1099511628211ULL;
+		}
+		return hash;
+	}
+	// Hash of the content of an embedded file (computed by bin2cpp, computed here for the files from elsewhere)
+	unsigned long long contentHash(const FileInfo & file);
+	// Find a file by the hash of its content (binary search), returns nullptr if not found
+	const FileInfo * findFileByHash(unsigned long long hash);
+)raw";
+
+	static const char * s_integrityHeaderContent = R"raw(
+	// Integrity verification of the embedded data, with the CRC32C of each block of crcBlockSize bytes
+	// computed by bin2cpp. A block is only verified on its first request (by these functions or by the content
+	// accessors of FileInfo), then the result is cached.
+	extern const unsigned int crcBlockSize;
+	// Verify the blocks covering the given range of an embedded file, returns false if one of them is corrupted
+	bool verifyContent(const FileInfo & file, size_t offset, size_t size);
+	inline bool verifyContent(const FileInfo & file) {
+		return verifyContent(file, 0, file.fileDataSize);
+	}
+	// Verify all the files on a background thread
+	void startVerify();
+	// Block until all the files have been verified (starting the verification if needed),
+	// returns false if a corrupted block was found
+	bool waitVerified();
+)raw";
+
+	static const char * s_packHeaderContent = R"raw(
+	// Read-only access to a pack file generated by bin2cpp -pack.
+	// The file is memory mapped: opening it only validates the tables in place (without allocation), and lookups are O(1).
+	class Pack {
+	public:
+		Pack() {
+		}
+		~Pack() {
+			close();
+		}
+		Pack(const Pack &) = delete;
+		Pack & operator=(const Pack &) = delete;
+
+		// Map the given pack file, returns false if it can't be opened or is not a valid pack
+		bool open(const char * path);
+		void close();
+
+		size_t size() const;
+		// File at the given position, in the pack order
+		FileInfo operator[](size_t index) const;
+		// Find a file by name, the returned FileInfo has a null fileData if not found
+		FileInfo find(const char * name) const;
+		FileInfo find(const std::string & name) const {
+			return find(name.c_str());
+		}
+
+		struct Iterator {
+			const Pack * pack;
+			size_t index;
+
+			FileInfo operator*() const {
+				return (*pack)[index];
+			}
+			Iterator & operator++() {
+				++index;
+				return *this;
+			}
+			bool operator!=(const Iterator & other) const {
+				return index != other.index;
+			}
+		};
+
+		Iterator begin() const {
+			return Iterator{ this, 0 };
+		}
+		Iterator end() const {
+			return Iterator{ this, size() };
+		}
+
+	private:
+		const unsigned char * data = nullptr;
+		size_t dataSize = 0;
+		// file mapping handle (Windows only)
+		void * mapping = nullptr;
+	};
+)raw";
+
+	static const char * s_vfsHeaderContent = R"raw(
+	// File of the virtual filesystem: an embedded file, or a file on disk overriding it
+	struct VfsEntry {
+		std::string name;
+		// embedded file (null fileData for a file on disk)
+		FileInfo file;
+		// path of the file on disk (empty for an embedded file)
+		std::string path;
+		int priority;
+
+		bool onDisk() const {
+			return !path.empty();
+		}
+		// Content of the file, read from the disk for a file on disk (throws std::runtime_error if it can't be read)
+		std::string content() const;
+	};
+
+	// Overlay of embedded bundles and disk directories, merged in an index built once.
+	// For each name, the layer with the highest priority wins (the last added one on a tie).
+	class Vfs {
+	public:
+		Vfs() {
+		}
+		~Vfs();
+		Vfs(const Vfs &) = delete;
+		Vfs & operator=(const Vfs &) = delete;
+
+		// Add the files of a bundle: fileList() of any bin2cpp generated code, or a Pack
+		template <typename Range>
+		void addBundle(const Range & files, int priority = 0) {
+			Layer & layer = addLayer(priority, std::string{});
+			for (const auto & file : files) {
+				layer.files.push_back(VfsEntry{ file.name(), bundleFile(file), std::string{}, priority });
+			}
+		}
+		// Add the files of a directory (recursively), named by their path relative to the directory
+		void addDirectory(const std::string & path, int priority = 1);
+
+		// Build the merged index, to be called after adding the layers
+		void build();
+		// Rebuild the index if the directories changed (watched with inotify on Linux, always rebuilt elsewhere).
+		// Returns true if the index was rebuilt. The entries previously found are then invalidated.
+		bool refresh();
+
+		// Find a file by name in O(1), returns nullptr if not found
+		const VfsEntry * find(const std::string & name) const;
+		const VfsEntry * find(const char * name) const {
+			return find(std::string{ name });
+		}
+		size_t size() const {
+			return index.size();
+		}
+
+	private:
+		struct Layer {
+			int priority;
+			// empty for a bundle
+			std::string directory;
+			std::vector<VfsEntry> files;
+		};
+
+		Layer & addLayer(int priority, const std::string & directory);
+		// scanning: device and inode of the directories being scanned, to stop at the symbolic link loops
+		void scanDirectory(Layer & layer, const std::string & path, const std::string & prefix, std::vector<std::pair<unsigned long long, unsigned long long>> & scanning);
+
+		// the position in fileInfoList is only meaningful for the files of this bundle
+		static FileInfo bundleFile(const FileInfo & file) {
+			return file;
+		}
+		template <typename OtherFileInfo>
+		static FileInfo bundleFile(const OtherFileInfo & file) {
+			return FileInfo{ file.fileName, file.fileData, file.fileDataSize, FileInfo::noFileIndex };
+		}
+
+		std::vector<Layer> layers;
+		std::unordered_map<std::string, const VfsEntry *> index;
+		// inotify file descriptor (Linux only)
+		int watch = -1;
+	};
+)raw";
+
+	static const char * s_sharedCacheHeaderContent = R"raw(
+	// Content decoded from an embedded file, mapped read-only from a shared memory segment (see sharedDecode())
+	class SharedContent {
+	public:
+		SharedContent() {
+		}
+		SharedContent(SharedContent && other);
+		SharedContent & operator=(SharedContent && other);
+		~SharedContent();
+
+		const char * data() const {
+			return view ? view + headerSize : local.data();
+		}
+		size_t size() const {
+			return contentSize;
+		}
+		// false if the content couldn't be shared and was decoded in this process
+		bool isShared() const {
+			return view != nullptr;
+		}
+
+	private:
+		friend SharedContent sharedDecode(const FileInfo &, const char *, const std::function<std::string(const FileInfo &)> &);
+		void release();
+
+		// the segment starts with a header, followed by the content
+		static const size_t headerSize = 16;
+		const char * view = nullptr;
+		size_t viewSize = 0;
+		// file mapping handle (Windows only)
+		void * mapping = nullptr;
+		std::string local;
+		size_t contentSize = 0;
+	};
+
+	// Decode a file once per user and host: the first process calls decode(file) and publishes the result in a shared memory
+	// segment named after the bundle, the file, the decoder name and the user. The other processes wait for it and map it
+	// read-only. On POSIX systems the segments are only readable by their user, and the ones created by another user are ignored.
+	// The files which aren't in fileInfoList (pack entries...) are decoded in this process only.
+	// On POSIX systems the segments persist until removed (or until the next reboot), on Windows while they're mapped.
+	SharedContent sharedDecode(const FileInfo & file, const char * decoderName, const std::function<std::string(const FileInfo &)> & decode);
+	// Remove the shared memory segment of a decoded file (POSIX only, the mapped contents stay valid)
+	void removeSharedContent(const FileInfo & file, const char * decoderName);
+)raw";
+
+	static const char * s_lazyDecodeHeaderContent = R"raw(
+	// Decode the block blockIndex of the content of a file to 'output' ('size' bytes: the block size, less for the last block)
+	typedef std::function<void(const FileInfo & file, size_t blockIndex, char * output, size_t size)> BlockDecoder;
+
+	// Return the decoded content of a file (decodedSize bytes) as plain memory, each block being decoded on its first access:
+	// on Linux the pages of a reserved range are filled by a userfaultfd handler thread calling decode().
+	// Elsewhere, if userfaultfd isn't allowed or if blockSize isn't a multiple of the page size, everything is decoded now.
+	// Without privileges, userfaultfd only handles the faults of the user code (UFFD_USER_MODE_ONLY): the pointer given to
+	// system calls (read(), write(), send()...) would fail with EFAULT, so the contents are decoded now as well.
+	// The file is copied. decode() shouldn't throw: when the blocks are decoded now, the exception is thrown by lazyDecode(),
+	// but an exception thrown while handling a fault leaves the block filled with zeros. The content is never released.
+	const char * lazyDecode(const FileInfo & file, size_t decodedSize, size_t blockSize, BlockDecoder decode);
+	// true if lazyDecode() decodes the blocks on demand
+	bool lazyDecodeSupported();
+)raw";
+
+	static const char * s_libraryGroupHeaderContent = R"raw(
+	// Files of an asset group (-dlgroup), embedded in a shared library loaded on demand
+	struct GroupFileRange {
+		const FileInfo * first;
+		size_t count;
+
+		const FileInfo * begin() const {
+			return first;
+		}
+		const FileInfo * end() const {
+			return first + count;
+		}
+		size_t size() const {
+			return count;
+		}
+	};
+
+	// Load the shared library of a group on the first call (thread-safe) and return its files.
+	// The range is empty if the group is unknown or if its library can't be loaded. The library is never unloaded.
+	GroupFileRange loadGroup(const std::string & group);
+	// Directory where to load the group libraries from (default: the search path of the system), to set before loadGroup()
+	void setGroupLibraryDirectory(const std::string & directory);
+)raw";
+
+	static const char * s_asyncHeaderContent = R"raw(
+	// Asynchronous access: the content is loaded by a pool of worker threads, from a copy of the FileInfo.
+	// The future reports the errors (a corrupted block with -crc for instance).
+	// The callbacks are invoked from a worker thread and must not throw: onError receives the error instead of
+	// the callback, a failed load is ignored without it.
+	std::future<std::string> loadContentAsync(const FileInfo & file);
+	void loadContentAsync(const FileInfo & file, std::function<void(std::string)> callback,
+		std::function<void(std::exception_ptr)> onError = nullptr);
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+	// Awaitable version: `std::string data = co_await loadContent(file);`
+	// The coroutine is resumed on the worker thread which loaded the content.
+	// The errors are rethrown by co_await.
+	struct ContentAwaitable {
+		FileInfo file;
+		std::string result;
+		std::exception_ptr error;
+
+		bool await_ready() const noexcept {
+			return false;
+		}
+		void await_suspend(std::coroutine_handle<> handle) {
+			loadContentAsync(file, [this, handle](std::string data) {
+				result = std::move(data);
+				handle.resume();
+			}, [this, handle](std::exception_ptr exception) {
+				error = exception;
+				handle.resume();
+			});
+		}
+		std::string await_resume() {
+			if (error) {
+				std::rethrow_exception(error);
+			}
+			return std::move(result);
+		}
+	};
+
+	inline ContentAwaitable loadContent(const FileInfo & file) {
+		return ContentAwaitable{ file, {}, nullptr };
+	}
+#endif
+)raw";
+
+	if (!options.namespaceName.empty()) {
+		stream << "\n";
+		stream << "namespace " << options.namespaceName << " {";
+	}
+	if (options.frontCodedNames) {
+		stream << s_headerFrontCodedNames;
+	}
+	if (options.crcBlockSize != 0) {
+		stream << s_headerCheckedContentDeclarations;
+	}
+	stream << s_headerFileInfo;
+	stream << (options.frontCodedNames ? s_headerFrontCodedName : s_headerPlainName);
+	stream << (options.crcBlockSize != 0 ? s_headerCheckedContent : s_headerContent);
+	stream << "\t};\n";
+	stream << s_headerFileList;
+	if (options.generatePreload) {
+		stream << s_preloadHeaderContent;
+	}
+	if (options.normalizedIndex) {
+		stream << s_normalizedIndexHeaderContent;
+	}
+	if (options.extensionIndex || !options.tags.empty()) {
+		stream << s_groupHeaderContent;
+	}
+	if (options.extensionIndex) {
+		stream << s_extensionIndexHeaderContent;
+	}
+	if (!options.tags.empty()) {
+		stream << s_tagIndexHeaderContent;
+	}
+	if (options.contentHashIndex) {
+		stream << s_contentHashIndexHeaderContent;
+	}
+	if (options.crcBlockSize != 0) {
+		stream << s_integrityHeaderContent;
+	}
+	if (!options.packFileName.empty()) {
+		stream << s_packHeaderContent;
+	}
+	if (options.generateVfs) {
+		stream << s_vfsHeaderContent;
+	}
+	if (options.generateSharedCache) {
+		stream << s_sharedCacheHeaderContent;
+	}
+	if (options.generateLazyDecode) {
+		stream << s_lazyDecodeHeaderContent;
+	}
+	if (!options.libraryGroups.empty()) {
+		stream << s_libraryGroupHeaderContent;
+	}
+	if (options.generateAsyncApi) {
+		stream << s_asyncHeaderContent;
+	}
+	if (!options.namespaceName.empty()) {
+		stream << "}\n";
+	}
+}
+
+void generateHeaderFile(const Options & options, OutputSink & sink, const Progress & progress) {
+	OutputFile output{ options.headerFileName, sink, progress };
+	std::ostream & stream = output.stream();
+
+	stream << "#pragma once\n";
+	stream << "\n";
+	writeApiIncludes(options, stream);
+	writeApiDeclarations(options, stream);
+	output.close();
+}
+
+void generatePreloadRuntime(const Options & options, std::ostream & stream) {
+	static const char * s_preloadRuntime = R"raw(
+	namespace /* anonymous */ {
+		struct PreloadState {
+			std::mutex mutex;
+			std::condition_variable fileLoaded;
+			std::vector<bool> loaded;
+			bool started = false;
+			std::thread worker;
+
+			~PreloadState() {
+				if (worker.joinable()) {
+					worker.join();
+				}
+			}
+		};
+
+		PreloadState & preloadState() {
+			static PreloadState state;
+			return state;
+		}
+
+		// read one byte per page so the OS maps the whole file data in memory
+		void touchPages(const FileInfo & file) {
+			volatile unsigned char sink = 0;
+			for (size_t i = 0; i < file.fileDataSize; i += 4096) {
+				sink = sink ^ static_cast<unsigned char>(file.fileData[i]);
+			}
+		}
+	}
+
+	void startPreload(const FileInfo * const * priorityList, size_t count) {
+		PreloadState & state = preloadState();
+		std::lock_guard<std::mutex> lock{ state.mutex };
+		if (state.started) {
+			return;
+		}
+		state.started = true;
+		state.loaded.assign(fileInfoListSize, false);
+
+		// priority files first, then the remaining ones in their embedding order
+		std::vector<const FileInfo *> order;
+		std::vector<bool> queued(fileInfoListSize, false);
+		for (size_t i = 0; i < count; ++i) {
+			const unsigned int index = embeddedIndex(*priorityList[i]);
+			if (index != FileInfo::noFileIndex && !queued[index]) {
+				queued[index] = true;
+				order.push_back(&fileInfoList[index]);
+			}
+		}
+		for (unsigned int i = 0; i < fileInfoListSize; ++i) {
+			if (!queued[i]) {
+				order.push_back(&fileInfoList[i]);
+			}
+		}
+
+		state.worker = std::thread{ [&state, order]() {
+			for (auto file : order) {
+				touchPages(*file);
+
+				std::lock_guard<std::mutex> lock{ state.mutex };
+				state.loaded[file->fileIndex] = true;
+				state.fileLoaded.notify_all();
+			}
+		} };
+	}
+
+	void waitPreloaded(const FileInfo & file) {
+		PreloadState & state = preloadState();
+		std::unique_lock<std::mutex> lock{ state.mutex };
+		const unsigned int index = embeddedIndex(file);
+		if (state.started && index != FileInfo::noFileIndex) {
+			state.fileLoaded.wait(lock, [&]() { return state.loaded[index]; });
+		}
+	}
+)raw";
+
+	stream << s_preloadRuntime;
+
+	// default order: the files listed with -preload (the list is null terminated to never be empty)
+	stream << "\n";
+	stream << "\tvoid startPreload() {\n";
+	stream << "\t\tstatic const FileInfo * const defaultOrder[] = { ";
+	for (auto name : options.preloadList) {
+		const auto it = std::find(options.inputFiles.begin(), options.inputFiles.end(), name);
+		if (it == options.inputFiles.end()) {
+			throw std::runtime_error{ "Preload list references a file which is not embedded: " + name };
+		}
+		stream << "&fileInfoList[" << (it - options.inputFiles.begin()) << "], ";
+	}
+	stream << "nullptr };\n";
+	stream << "\t\tstartPreload(defaultOrder, " << options.preloadList.size() << ");\n";
+	stream << "\t}\n";
+}
+
+const unsigned int s_nameBlockSize = 16;
+
+// Front-coded table of the sorted file names: each name is stored as its shared prefix size with
+// the previous name, its suffix size (both as varints) and its suffix. The first name of each
+// block of s_nameBlockSize names is stored in full so a lookup can binary search the blocks.
+struct NameTable {
+	// index of the files sorted by name
+	std::vector<unsigned int> sortedIndex;
+	// position of each file in sortedIndex
+	std::vector<unsigned int> ranks;
+	std::vector<unsigned char> data;
+	std::vector<unsigned int> blockOffsets;
+};
+
+void appendVarint(std::vector<unsigned char> & data, size_t value) {
+	while (value >= 0x80) {
+		data.push_back(static_cast<unsigned char>(value | 0x80));
+		value >>= 7;
+	}
+	data.push_back(static_cast<unsigned char>(value));
+}
+
+NameTable buildNameTable(const std::vector<std::string> & names) {
+	NameTable table;
+	for (unsigned int i = 0; i < names.size(); ++i) {
+		table.sortedIndex.push_back(i);
+	}
+	// std::string compares characters as unsigned char, like strcmp()
+	std::stable_sort(table.sortedIndex.begin(), table.sortedIndex.end(), [&](unsigned int a, unsigned int b) {
+		return names[a] < names[b];
+	});
+
+	table.ranks.resize(names.size());
+	const std::string * previous = nullptr;
+	for (unsigned int rank = 0; rank < table.sortedIndex.size(); ++rank) {
+		const std::string & name = names[table.sortedIndex[rank]];
+		table.ranks[table.sortedIndex[rank]] = rank;
+
+		size_t shared = 0;
+		if (rank % s_nameBlockSize == 0) {
+			table.blockOffsets.push_back(static_cast<unsigned int>(table.data.size()));
+		}
+		else {
+			while (shared < name.size() && shared < previous->size() && name[shared] == (*previous)[shared]) {
+				++shared;
+			}
+		}
+		appendVarint(table.data, shared);
+		appendVarint(table.data, name.size() - shared);
+		table.data.insert(table.data.end(), name.begin() + shared, name.end());
+		previous = &name;
+	}
+	return table;
+}
+
+// Write the initializer of a C array (a single 0 for an empty array since C++ forbids them)
+template <typename T>
+void writeArrayValues(std::ostream & stream, const std::vector<T> & values, const std::string & indent = "\t") {
+	stream << "{";
+	for (size_t i = 0; i < values.size(); ++i) {
+		if (i % 20 == 0) {
+			stream << "\n" << indent << "\t";
+		}
+		stream << static_cast<unsigned int>(values[i]) << ",";
+	}
+	if (values.empty()) {
+		stream << " 0 ";
+	}
+	else {
+		stream << "\n" << indent;
+	}
+	stream << "}";
+}
+
+void generateNameLookup(const Options & options, std::ostream & stream) {
+	static const char * s_plainLookupRuntime = R"raw(
+	const FileInfo * findFile(const char * name) {
+		const unsigned int * first = &sortedFileIndex[0];
+		const unsigned int * last = first + fileInfoListSize;
+		first = std::lower_bound(first, last, name, [](unsigned int index, const char * key) {
+			return std::strcmp(fileInfoList[index].fileName, key) < 0;
+		});
+		if (first != last && std::strcmp(fileInfoList[*first].fileName, name) == 0) {
+			return &fileInfoList[*first];
+		}
+		return nullptr;
+	}
+)raw";
+
+	static const char * s_frontCodedLookupRuntime = R"raw(
+	namespace /* anonymous */ {
+		unsigned int readNameVarint(const unsigned char *& cursor) {
+			unsigned int value = 0;
+			for (unsigned int shift = 0;; shift += 7) {
+				const unsigned char byte = *cursor++;
+				value |= static_cast<unsigned int>(byte & 0x7F) << shift;
+				if ((byte & 0x80) == 0) {
+					return value;
+				}
+			}
+		}
+
+		// compare the first name of a block (which is stored in full) with the searched one
+		int compareBlockName(unsigned int block, const char * name, size_t nameSize) {
+			const unsigned char * cursor = &nameTable[nameBlockOffsets[block]];
+			readNameVarint(cursor);
+			const unsigned int size = readNameVarint(cursor);
+			const int result = std::memcmp(cursor, name, size < nameSize ? size : nameSize);
+			if (result != 0) {
+				return result;
+			}
+			return size < nameSize ? -1 : (size > nameSize ? 1 : 0);
+		}
+	}
+
+	std::string decodeFileName(const FileInfo & file) {
+		const unsigned int index = embeddedIndex(file);
+		if (index == FileInfo::noFileIndex) {
+			return std::string{};
+		}
+		// decode the names of the block up to the wanted one
+		const unsigned int rank = fileNameRank[index];
+		const unsigned char * cursor = &nameTable[nameBlockOffsets[rank / nameBlockSize]];
+		std::string name;
+		for (unsigned int i = rank - rank % nameBlockSize; i <= rank; ++i) {
+			const unsigned int shared = readNameVarint(cursor);
+			const unsigned int suffixSize = readNameVarint(cursor);
+			name.resize(shared);
+			name.append(reinterpret_cast<const char *>(cursor), suffixSize);
+			cursor += suffixSize;
+		}
+		return name;
+	}
+
+	const FileInfo * findFile(const char * name) {
+		const size_t nameSize = std::strlen(name);
+		if (nameBlockCount == 0 || compareBlockName(0, name, nameSize) > 0) {
+			return nullptr;
+		}
+
+		// binary search of the last block whose first name is <= the searched one
+		unsigned int first = 0;
+		unsigned int last = nameBlockCount;
+		while (last - first > 1) {
+			const unsigned int middle = first + (last - first) / 2;
+			if (compareBlockName(middle, name, nameSize) <= 0) {
+				first = middle;
+			}
+			else {
+				last = middle;
+			}
+		}
+
+		// scan the block without decoding the names: 'matched' is the size of the
+		// common prefix between the previous name (smaller) and the searched one
+		const unsigned char * cursor = &nameTable[nameBlockOffsets[first]];
+		size_t matched = 0;
+		const unsigned int end = (first + 1) * nameBlockSize < fileInfoListSize ? (first + 1) * nameBlockSize : fileInfoListSize;
+		for (unsigned int rank = first * nameBlockSize; rank < end; ++rank) {
+			const unsigned int shared = readNameVarint(cursor);
+			const unsigned int suffixSize = readNameVarint(cursor);
+			const unsigned char * suffix = cursor;
+			cursor += suffixSize;
+
+			if (shared > matched) {
+				// same difference with the searched name as the previous one: still smaller
+				continue;
+			}
+			if (shared < matched) {
+				// differs sooner from the previous name, with a greater character: greater
+				return nullptr;
+			}
+			size_t i = 0;
+			while (i < suffixSize && matched + i < nameSize && suffix[i] == static_cast<unsigned char>(name[matched + i])) {
+				++i;
+			}
+			matched += i;
+			if (i == suffixSize) {
+				if (matched == nameSize) {
+					return &fileInfoList[sortedFileIndex[rank]];
+				}
+				// prefix of the searched name: smaller
+				continue;
+			}
+			if (matched == nameSize || suffix[i] > static_cast<unsigned char>(name[matched])) {
+				return nullptr;
+			}
+		}
+		return nullptr;
+	}
+)raw";
+
+	const NameTable table = buildNameTable(options.inputFiles);
+
+	stream << "\n";
+	stream << "\tconst unsigned int sortedFileIndex[] = ";
+	writeArrayValues(stream, table.sortedIndex);
+	stream << ";\n";
+
+	if (options.frontCodedNames) {
+		stream << "\n";
+		stream << "\tnamespace /* anonymous */ {\n";
+		stream << "\t\tconst unsigned int nameBlockSize = " << s_nameBlockSize << ";\n";
+		stream << "\t\tconst unsigned int nameBlockCount = " << table.blockOffsets.size() << ";\n";
+		stream << "\t\tconst unsigned int nameBlockOffsets[] = ";
+		writeArrayValues(stream, table.blockOffsets, "\t\t");
+		stream << ";\n";
+		stream << "\t\tconst unsigned int fileNameRank[] = ";
+		writeArrayValues(stream, table.ranks, "\t\t");
+		stream << ";\n";
+		stream << "\t\tconst unsigned char nameTable[] = ";
+		writeArrayValues(stream, table.data, "\t\t");
+		stream << ";\n";
+		stream << "\t}\n";
+		stream << s_frontCodedLookupRuntime;
+	}
+	else {
+		stream << s_plainLookupRuntime;
+	}
+}
+
+// Normalize a file name for findFileNormalized(): ASCII lower case, '/' separators,
+// without empty nor "." segments (must match the NormalizedName runtime class)
+std::string normalizeName(const std::string & name) {
+	std::string result;
+	size_t segmentStart = 0;
+	while (segmentStart <= name.size()) {
+		auto segmentEnd = name.find_first_of("/\\", segmentStart);
+		if (segmentEnd == std::string::npos) {
+			segmentEnd = name.size();
+		}
+		const std::string segment = name.substr(segmentStart, segmentEnd - segmentStart);
+		if (!segment.empty() && segment != ".") {
+			if (!result.empty()) {
+				result += '/';
+			}
+			for (char c : segment) {
+				result += (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+			}
+		}
+		segmentStart = segmentEnd + 1;
+	}
+	return result;
+}
+
+void generateNormalizedIndex(const Options & options, std::ostream & stream) {
+	static const char * s_normalizedIndexRuntime = R"raw(
+	namespace /* anonymous */ {
+		bool isSeparator(char c) {
+			return c == '/' || c == '\\';
+		}
+
+		// skip the separators and the "." segments
+		const char * skipEmptySegments(const char * name) {
+			for (;;) {
+				if (isSeparator(name[0])) {
+					++name;
+				}
+				else if (name[0] == '.' && (isSeparator(name[1]) || name[1] == '\0')) {
+					++name;
+				}
+				else {
+					return name;
+				}
+			}
+		}
+
+		// reads the characters of a name as they are once normalized (without allocating)
+		class NormalizedName {
+		public:
+			explicit NormalizedName(const char * name) : cursor{ skipEmptySegments(name) } {
+			}
+
+			// next normalized character ('\0' at the end)
+			unsigned char take() {
+				if (*cursor == '\0') {
+					return '\0';
+				}
+				if (isSeparator(*cursor)) {
+					cursor = skipEmptySegments(cursor);
+					return *cursor == '\0' ? '\0' : '/';
+				}
+				const unsigned char c = static_cast<unsigned char>(*cursor++);
+				return (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c - 'A' + 'a') : c;
+			}
+
+		private:
+			const char * cursor;
+		};
+	}
+
+	const FileInfo * findFileNormalized(const char * name) {
+		// single pass over the name: each character narrows the range of the sorted keys
+		// which share the characters read so far
+		NormalizedName query{ name };
+		const unsigned int * first = &normalizedFileIndex[0];
+		const unsigned int * last = first + fileInfoListSize;
+		for (size_t position = 0; first != last; ++position) {
+			const unsigned char c = query.take();
+			auto keyChar = [position](unsigned int index) {
+				return static_cast<unsigned char>(normalizedKeys[index][position]);
+			};
+			first = std::lower_bound(first, last, c, [&](unsigned int index, unsigned char value) {
+				return keyChar(index) < value;
+			});
+			last = std::upper_bound(first, last, c, [&](unsigned char value, unsigned int index) {
+				return value < keyChar(index);
+			});
+			if (c == '\0') {
+				return first != last ? &fileInfoList[*first] : nullptr;
+			}
+		}
+		return nullptr;
+	}
+)raw";
+
+	std::vector<std::string> keys;
+	std::vector<unsigned int> sortedIndex;
+	for (unsigned int i = 0; i < options.inputFiles.size(); ++i) {
+		keys.push_back(normalizeName(options.inputFiles[i]));
+		sortedIndex.push_back(i);
+	}
+	std::stable_sort(sortedIndex.begin(), sortedIndex.end(), [&](unsigned int a, unsigned int b) {
+		return keys[a] < keys[b];
+	});
+
+	stream << "\n";
+	stream << "\tnamespace /* anonymous */ {\n";
+	stream << "\t\t// normalized names of the files, indexed by fileInfoList position\n";
+	stream << "\t\tconst char * const normalizedKeys[] = {";
+	for (auto key : keys) {
+		stream << "\n\t\t\t" << cppStringLiteral(key) << ",";
+	}
+	stream << (keys.empty() ? " nullptr };\n" : "\n\t\t};\n");
+	stream << "\t\t// index of the files sorted by normalized name\n";
+	stream << "\t\tconst unsigned int normalizedFileIndex[] = ";
+	writeArrayValues(stream, sortedIndex, "\t\t");
+	stream << ";\n";
+	stream << "\t}\n";
+	stream << s_normalizedIndexRuntime;
+}
+
+// Extension of a file name, including the dot (empty for ".gitignore" or "Makefile")
+std::string fileExtension(const std::string & path) {
+	const auto separator = path.rfind('/');
+	const auto fileNameStart = separator == std::string::npos ? 0 : separator + 1;
+	const auto dot = path.rfind('.');
+	if (dot == std::string::npos || dot <= fileNameStart) {
+		return std::string{};
+	}
+	return path.substr(dot);
+}
+
+// Write the files grouped by key: a table of the groups sorted by key, and the indexes of their files
+void writeFileGroups(const std::string & name, const std::map<std::string, std::vector<unsigned int>> & groups, std::ostream & stream) {
+	std::vector<unsigned int> fileIndex;
+	stream << "\t\tconst unsigned int " << name << "GroupCount = " << groups.size() << ";\n";
+	stream << "\t\tconst FileGroup " << name << "Groups[] = {";
+	for (const auto & group : groups) {
+		stream << "\n\t\t\t{ " << cppStringLiteral(group.first) << ", " << fileIndex.size() << ", " << group.second.size() << " },";
+		fileIndex.insert(fileIndex.end(), group.second.begin(), group.second.end());
+	}
+	stream << (groups.empty() ? " { nullptr, 0, 0 } };\n" : "\n\t\t};\n");
+	stream << "\t\tconst unsigned int " << name << "FileIndex[] = ";
+	writeArrayValues(stream, fileIndex, "\t\t");
+	stream << ";\n";
+}
+
+void generateGroupIndexes(const Options & options, std::ostream & stream) {
+	static const char * s_groupRuntime = R"raw(
+	namespace /* anonymous */ {
+		// binary search of a group in a table sorted by key
+		IndexedFileRange findFileGroup(const FileGroup * groups, unsigned int groupCount, const unsigned int * fileIndex, const char * key) {
+			const FileGroup * last = groups + groupCount;
+			const FileGroup * group = std::lower_bound(groups, last, key, [](const FileGroup & group, const char * value) {
+				return std::strcmp(group.key, value) < 0;
+			});
+			if (group == last || std::strcmp(group->key, key) != 0) {
+				return IndexedFileRange{ fileIndex, fileIndex };
+			}
+			return IndexedFileRange{ fileIndex + group->first, fileIndex + group->first + group->count };
+		}
+	}
+)raw";
+
+	static const char * s_extensionIndexRuntime = R"raw(
+	IndexedFileRange filesByExtension(const char * extension) {
+		return findFileGroup(extensionGroups, extensionGroupCount, extensionFileIndex, extension);
+	}
+)raw";
+
+	static const char * s_tagIndexRuntime = R"raw(
+	IndexedFileRange filesByTag(const char * tag) {
+		return findFileGroup(tagGroups, tagGroupCount, tagFileIndex, tag);
+	}
+)raw";
+
+	stream << "\n";
+	stream << "\tnamespace /* anonymous */ {\n";
+	stream << "\t\t// files of a group are fileIndex[first] to fileIndex[first + count - 1]\n";
+	stream << "\t\tstruct FileGroup {\n";
+	stream << "\t\t\tconst char * key;\n";
+	stream << "\t\t\tunsigned int first;\n";
+	stream << "\t\t\tunsigned int count;\n";
+	stream << "\t\t};\n";
+	if (options.extensionIndex) {
+		std::map<std::string, std::vector<unsigned int>> groups;
+		for (unsigned int i = 0; i < options.inputFiles.size(); ++i) {
+			groups[fileExtension(options.inputFiles[i])].push_back(i);
+		}
+		writeFileGroups("extension", groups, stream);
+	}
+	if (!options.tags.empty()) {
+		std::map<std::string, std::vector<unsigned int>> groups;
+		for (unsigned int i = 0; i < options.inputFiles.size(); ++i) {
+			for (const auto & rule : options.tags) {
+				auto & files = groups[rule.tag];
+				// several rules can give the same tag to a file
+				if (matchGlob(rule.pattern, options.inputFiles[i]) && (files.empty() || files.back() != i)) {
+					files.push_back(i);
+				}
+			}
+		}
+		writeFileGroups("tag", groups, stream);
+	}
+	stream << "\t}\n";
+
+	stream << s_groupRuntime;
+	if (options.extensionIndex) {
+		stream << s_extensionIndexRuntime;
+	}
+	if (!options.tags.empty()) {
+		stream << s_tagIndexRuntime;
+	}
+}
+
+void writeHashValues(std::ostream & stream, const std::vector<unsigned long long> & values) {
+	std::ios::fmtflags flags(stream.flags());
+	stream << "{" << std::hex;
+	for (size_t i = 0; i < values.size(); ++i) {
+		stream << (i % 4 == 0 ? "\n\t\t\t" : " ") << "0x" << values[i] << "ULL,";
+	}
+	stream << (values.empty() ? " 0 }" : "\n\t\t}");
+	stream.flags(flags);
+}
+
+void generateContentHashIndex(const std::vector<unsigned long long> & contentHashes, std::ostream & stream) {
+	static const char * s_contentHashIndexRuntime = R"raw(
+	unsigned long long contentHash(const FileInfo & file) {
+		const unsigned int index = embeddedIndex(file);
+		if (index == FileInfo::noFileIndex) {
+			return hashContent(file.fileData, file.fileDataSize);
+		}
+		return contentHashes[index];
+	}
+
+	const FileInfo * findFileByHash(unsigned long long hash) {
+		const unsigned long long * last = sortedContentHashes + fileInfoListSize;
+		const unsigned long long * found = std::lower_bound(sortedContentHashes, last, hash);
+		if (found == last || *found != hash) {
+			return nullptr;
+		}
+		return &fileInfoList[contentHashFileIndex[found - sortedContentHashes]];
+	}
+)raw";
+
+	// the files with the same content are kept in the embedding order
+	std::vector<unsigned int> sortedIndex;
+	for (unsigned int i = 0; i < contentHashes.size(); ++i) {
+		sortedIndex.push_back(i);
+	}
+	std::stable_sort(sortedIndex.begin(), sortedIndex.end(), [&](unsigned int a, unsigned int b) {
+		return contentHashes[a] < contentHashes[b];
+	});
+	std::vector<unsigned long long> sortedHashes;
+	for (auto i : sortedIndex) {
+		sortedHashes.push_back(contentHashes[i]);
+	}
+
+	stream << "\n";
+	stream << "\tnamespace /* anonymous */ {\n";
+	stream << "\t\t// hash of the content of the files, indexed by fileInfoList position\n";
+	stream << "\t\tconst unsigned long long contentHashes[] = ";
+	writeHashValues(stream, contentHashes);
+	stream << ";\n";
+	stream << "\t\t// sorted hashes, and the position in fileInfoList of the matching file\n";
+	stream << "\t\tconst unsigned long long sortedContentHashes[] = ";
+	writeHashValues(stream, sortedHashes);
+	stream << ";\n";
+	stream << "\t\tconst unsigned int contentHashFileIndex[] = ";
+	writeArrayValues(stream, sortedIndex, "\t\t");
+	stream << ";\n";
+	stream << "\t}\n";
+	stream << s_contentHashIndexRuntime;
+}
+
+void generateIntegrityRuntime(const Options & options, const std::vector<DataDigest> & digests, std::ostream & stream) {
+	static const char * s_integrityRuntime = R"raw(
+	namespace /* anonymous */ {
+		std::uint32_t crc32cSoftware(std::uint32_t crc, const unsigned char * data, size_t size) {
+			for (size_t i = 0; i < size; ++i) {
+				crc = crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+			}
+			return crc;
+		}
+
+#if defined(__x86_64__) || defined(_M_X64)
+#if defined(__GNUC__)
+		__attribute__((target("sse4.2")))
+#endif
+		std::uint32_t crc32cHardware(std::uint32_t crc, const unsigned char * data, size_t size) {
+			std::uint64_t crc64 = crc;
+			for (; size >= 8; size -= 8, data += 8) {
+				std::uint64_t value;
+				std::memcpy(&value, data, sizeof(value));
+				crc64 = _mm_crc32_u64(crc64, value);
+			}
+			crc = static_cast<std::uint32_t>(crc64);
+			for (; size > 0; --size, ++data) {
+				crc = _mm_crc32_u8(crc, *data);
+			}
+			return crc;
+		}
+
+		bool hasCrc32Instructions() {
+#if defined(_MSC_VER)
+			int info[4];
+			__cpuid(info, 1);
+			return (info[2] & (1 << 20)) != 0;
+#else
+			return __builtin_cpu_supports("sse4.2");
+#endif
+		}
+#endif
+
+		std::uint32_t crc32c(const unsigned char * data, size_t size) {
+#if defined(__x86_64__) || defined(_M_X64)
+			static const bool hardware = hasCrc32Instructions();
+			if (hardware) {
+				return ~crc32cHardware(0xFFFFFFFF, data, size);
+			}
+#endif
+			return ~crc32cSoftware(0xFFFFFFFF, data, size);
+		}
+
+		// 0: not verified yet, 1: valid, 2: corrupted
+		std::atomic<unsigned char> crcBlockStates[crcBlockCount];
+
+		bool verifyBlock(unsigned int fileIndex, unsigned int block) {
+			const unsigned int id = crcFirstBlock[fileIndex] + block;
+			unsigned char state = crcBlockStates[id].load(std::memory_order_acquire);
+			if (state == 0) {
+				// concurrent verifications of a block give the same result
+				const FileInfo & file = fileInfoList[fileIndex];
+				const unsigned int offset = block * crcBlockSize;
+				const unsigned int size = file.fileDataSize - offset < crcBlockSize ? file.fileDataSize - offset : crcBlockSize;
+				state = crc32c(reinterpret_cast<const unsigned char *>(file.fileData) + offset, size) == crcBlockValues[id] ? 1 : 2;
+				crcBlockStates[id].store(state, std::memory_order_release);
+			}
+			return state == 1;
+		}
+
+		struct VerifyState {
+			std::mutex mutex;
+			std::condition_variable verified;
+			bool started = false;
+			bool done = false;
+			bool valid = true;
+			std::atomic<bool> stopping{ false };
+			std::thread worker;
+
+			~VerifyState() {
+				stopping = true;
+				if (worker.joinable()) {
+					worker.join();
+				}
+			}
+		};
+
+		VerifyState & verifyState() {
+			static VerifyState state;
+			return state;
+		}
+	}
+
+	bool verifyContent(const FileInfo & file, size_t offset, size_t size) {
+		// the blocks and their CRCs are the ones of the entry
+		const unsigned int index = embeddedIndex(file);
+		if (index == FileInfo::noFileIndex) {
+			return false;
+		}
+		if (offset >= file.fileDataSize) {
+			return true;
+		}
+		const size_t end = size < file.fileDataSize - offset ? offset + size : file.fileDataSize;
+		bool valid = true;
+		for (size_t block = offset / crcBlockSize; block * crcBlockSize < end; ++block) {
+			valid = verifyBlock(index, static_cast<unsigned int>(block)) && valid;
+		}
+		return valid;
+	}
+
+	void checkContent(const FileInfo & file, size_t offset, size_t size) {
+		if (embeddedIndex(file) != FileInfo::noFileIndex && !verifyContent(file, offset, size)) {
+			throw std::runtime_error{ "Corrupted embedded data: " + file.name() };
+		}
+	}
+
+	void startVerify() {
+		VerifyState & state = verifyState();
+		std::lock_guard<std::mutex> lock{ state.mutex };
+		if (state.started) {
+			return;
+		}
+		state.started = true;
+
+		state.worker = std::thread{ [&state]() {
+			bool valid = true;
+			for (unsigned int i = 0; i < fileInfoListSize && !state.stopping; ++i) {
+				for (unsigned int block = 0; block < crcFirstBlock[i + 1] - crcFirstBlock[i] && !state.stopping; ++block) {
+					valid = verifyBlock(i, block) && valid;
+				}
+			}
+
+			std::lock_guard<std::mutex> lock{ state.mutex };
+			state.done = true;
+			state.valid = valid;
+			state.verified.notify_all();
+		} };
+	}
+
+	bool waitVerified() {
+		startVerify();
+		VerifyState & state = verifyState();
+		std::unique_lock<std::mutex> lock{ state.mutex };
+		state.verified.wait(lock, [&]() { return state.done; });
+		return state.valid;
+	}
+)raw";
+
+	std::vector<unsigned int> firstBlocks;
+	std::vector<unsigned int> blockCrcs;
+	for (const auto & digest : digests) {
+		firstBlocks.push_back(static_cast<unsigned int>(blockCrcs.size()));
+		blockCrcs.insert(blockCrcs.end(), digest.blockCrcs.begin(), digest.blockCrcs.end());
+	}
+	firstBlocks.push_back(static_cast<unsigned int>(blockCrcs.size()));
+
+	std::vector<unsigned int> table{ crc32cTable(), crc32cTable() + 256 };
+
+	stream << "\n";
+	stream << "\tconst unsigned int crcBlockSize = " << options.crcBlockSize << ";\n";
+	stream << "\n";
+	stream << "\tnamespace /* anonymous */ {\n";
+	stream << "\t\tconst std::uint32_t crcTable[256] = ";
+	writeArrayValues(stream, table, "\t\t");
+	stream << ";\n";
+	stream << "\t\t// CRC32C of the blocks, the blocks of fileInfoList[i] are crcFirstBlock[i] to crcFirstBlock[i + 1] - 1\n";
+	stream << "\t\tconst unsigned int crcBlockCount = " << std::max<size_t>(blockCrcs.size(), 1) << ";\n";
+	stream << "\t\tconst std::uint32_t crcBlockValues[] = ";
+	writeArrayValues(stream, blockCrcs, "\t\t");
+	stream << ";\n";
+	stream << "\t\tconst unsigned int crcFirstBlock[] = ";
+	writeArrayValues(stream, firstBlocks, "\t\t");
+	stream << ";\n";
+	stream << "\t}\n";
+	stream << s_integrityRuntime;
+}
+
+void generateAsyncRuntime(std::ostream & stream) {
+	static const char * s_asyncRuntime = R"raw(
+	namespace /* anonymous */ {
+		// pool of worker threads started on first use
+		class AsyncLoader {
+		public:
+			~AsyncLoader() {
+				{
+					std::lock_guard<std::mutex> lock{ mutex };
+					stopping = true;
+				}
+				wakeUp.notify_all();
+				for (auto & worker : workers) {
+					worker.join();
+				}
+			}
+
+			void post(std::function<void()> task) {
+				std::lock_guard<std::mutex> lock{ mutex };
+				if (workers.empty()) {
+					const unsigned int count = std::thread::hardware_concurrency();
+					for (unsigned int i = 0; i < (count > 0 ? count : 1); ++i) {
+						workers.emplace_back([this]() { run(); });
+					}
+				}
+				tasks.push_back(std::move(task));
+				wakeUp.notify_one();
+			}
+
+		private:
+			void run() {
+				for (;;) {
+					std::function<void()> task;
+					{
+						std::unique_lock<std::mutex> lock{ mutex };
+						wakeUp.wait(lock, [this]() { return stopping || !tasks.empty(); });
+						if (tasks.empty()) {
+							return;
+						}
+						task = std::move(tasks.front());
+						tasks.pop_front();
+					}
+					task();
+				}
+			}
+
+			std::mutex mutex;
+			std::condition_variable wakeUp;
+			std::deque<std::function<void()>> tasks;
+			std::vector<std::thread> workers;
+			bool stopping = false;
+		};
+
+		AsyncLoader & asyncLoader() {
+			static AsyncLoader loader;
+			return loader;
+		}
+	}
+
+	std::future<std::string> loadContentAsync(const FileInfo & file) {
+		auto promise = std::make_shared<std::promise<std::string>>();
+		auto result = promise->get_future();
+		// the FileInfo is copied: the caller's one may be a temporary
+		asyncLoader().post([file, promise]() {
+			try {
+				promise->set_value(file.content());
+			}
+			catch (...) {
+				promise->set_exception(std::current_exception());
+			}
+		});
+		return result;
+	}
+
+	void loadContentAsync(const FileInfo & file, std::function<void(std::string)> callback,
+		std::function<void(std::exception_ptr)> onError) {
+		asyncLoader().post([file, callback, onError]() {
+			std::string content;
+			try {
+				content = file.content();
+			}
+			catch (...) {
+				if (onError) {
+					onError(std::current_exception());
+				}
+				return;
+			}
+			callback(std::move(content));
+		});
+	}
+)raw";
+
+	stream << s_asyncRuntime;
+}
+
+// Pack files layout (all integers are little endian):
+//	header		: PackHeader (64 bytes)
+//	buckets		: uint32[bucketCount], open addressing hash table of the names (entry index + 1, 0 if empty)
+//	entries		: PackEntry[fileCount] (32 bytes each)
+//	names		: null terminated file names
+//	data		: content of the files, each one aligned on s_packAlignment bytes
+const char s_packMagic[8] = { 'B', 'I', 'N', '2', 'C', 'P', 'K', '\0' };
+const unsigned int s_packVersion = 1;
+const unsigned int s_packHeaderSize = 64;
+const unsigned int s_packEntrySize = 32;
+const unsigned int s_packAlignment = 16;
+
+void writeLittleEndian(std::ostream & stream, unsigned long long value, unsigned int size) {
+	for (unsigned int i = 0; i < size; ++i) {
+		stream.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+	}
+}
+
+unsigned long long alignPackOffset(unsigned long long offset) {
+	return (offset + s_packAlignment - 1) / s_packAlignment * s_packAlignment;
+}
+
+void generatePackFile(const Options & options, const std::map<std::string, std::string> & transformedFiles, Generator::Impl & generator, OutputSink & sink, const Progress & progress) {
+	const auto & files = options.inputFiles;
+
+	// the load factor of the hash table is kept below 50%
+	unsigned int bucketCount = 1;
+	while (bucketCount < files.size() * 2) {
+		bucketCount *= 2;
+	}
+
+	std::vector<unsigned long long> nameHashes;
+	std::vector<unsigned long long> dataSizes;
+	unsigned long long namesSize = 0;
+	for (auto path : files) {
+		nameHashes.push_back(hashData(path));
+		const auto transformed = transformedFiles.find(path);
+		dataSizes.push_back(transformed != transformedFiles.end() ? transformed->second.size() : inputFileSize(options, path));
+		namesSize += path.size() + 1;
+	}
+
+	std::vector<unsigned int> buckets(bucketCount, 0);
+	for (unsigned int i = 0; i < files.size(); ++i) {
+		auto bucket = nameHashes[i] & (bucketCount - 1);
+		while (buckets[bucket] != 0) {
+			bucket = (bucket + 1) & (bucketCount - 1);
+		}
+		buckets[bucket] = i + 1;
+	}
+
+	const unsigned long long bucketsOffset = s_packHeaderSize;
+	const unsigned long long entriesOffset = alignPackOffset(bucketsOffset + 4ULL * bucketCount);
+	const unsigned long long namesOffset = entriesOffset + s_packEntrySize * files.size();
+	std::vector<unsigned long long> dataOffsets;
+	unsigned long long packSize = namesOffset + namesSize;
+	for (auto size : dataSizes) {
+		packSize = alignPackOffset(packSize);
+		dataOffsets.push_back(packSize);
+		packSize += size;
+	}
+
+	OutputFile output{ options.packFileName, sink, progress };
+	std::ostream & stream = output.stream();
+	unsigned long long position = 0;
+	auto padTo = [&](unsigned long long offset) {
+		for (; position < offset; ++position) {
+			stream.put('\0');
+		}
+	};
+
+	stream.write(s_packMagic, sizeof(s_packMagic));
+	writeLittleEndian(stream, s_packVersion, 4);
+	writeLittleEndian(stream, files.size(), 4);
+	writeLittleEndian(stream, bucketCount, 4);
+	writeLittleEndian(stream, 0, 4);
+	writeLittleEndian(stream, bucketsOffset, 8);
+	writeLittleEndian(stream, entriesOffset, 8);
+	writeLittleEndian(stream, namesOffset, 8);
+	writeLittleEndian(stream, namesSize, 8);
+	writeLittleEndian(stream, packSize, 8);
+	position = s_packHeaderSize;
+
+	for (auto bucket : buckets) {
+		writeLittleEndian(stream, bucket, 4);
+	}
+	position += 4ULL * bucketCount;
+	padTo(entriesOffset);
+
+	unsigned long long nameOffset = 0;
+	for (unsigned int i = 0; i < files.size(); ++i) {
+		writeLittleEndian(stream, nameHashes[i], 8);
+		writeLittleEndian(stream, nameOffset, 4);
+		writeLittleEndian(stream, files[i].size(), 4);
+		writeLittleEndian(stream, dataOffsets[i], 8);
+		writeLittleEndian(stream, dataSizes[i], 8);
+		nameOffset += files[i].size() + 1;
+	}
+	for (auto path : files) {
+		stream.write(path.c_str(), path.size() + 1);
+	}
+	position = namesOffset + namesSize;
+
+	for (unsigned int i = 0; i < files.size(); ++i) {
+		padTo(dataOffsets[i]);
+		notify(progress.onInputFile, files[i]);
+		const auto transformed = transformedFiles.find(files[i]);
+		if (transformed != transformedFiles.end()) {
+			stream.write(transformed->second.data(), transformed->second.size());
+		}
+		else if (dataSizes[i] > 0) {
+			// copied by chunks, the archive members are streamed from their archive
+			const auto inputFile = openInputFile(options, generator, files[i]);
+			std::vector<char> buffer(65536);
+			for (unsigned long long remaining = dataSizes[i]; remaining > 0;) {
+				const auto count = static_cast<std::streamsize>(std::min<unsigned long long>(remaining, buffer.size()));
+				if (!inputFile->read(buffer.data(), count)) {
+					throw std::runtime_error{ "Failed to read file " + files[i] };
+				}
+				stream.write(buffer.data(), count);
+				remaining -= static_cast<unsigned long long>(count);
+			}
+		}
+		position += dataSizes[i];
+		DataCounter counter{ progress.counters };
+		counter.add(dataSizes[i]);
+		counter.fileDone();
+	}
+	output.close();
+}
+
+void generatePackRuntime(std::ostream & stream) {
+	static const char * s_packRuntime = R"raw(
+	namespace /* anonymous */ {
+		// layout of the pack files (see bin2cpp), read in place from the mapped file
+		struct PackHeader {
+			char magic[8];
+			std::uint32_t version;
+			std::uint32_t fileCount;
+			std::uint32_t bucketCount;
+			std::uint32_t reserved;
+			std::uint64_t bucketsOffset;
+			std::uint64_t entriesOffset;
+			std::uint64_t namesOffset;
+			std::uint64_t namesSize;
+			std::uint64_t packSize;
+		};
+
+		struct PackEntry {
+			std::uint64_t nameHash;
+			std::uint32_t nameOffset;
+			std::uint32_t nameSize;
+			std::uint64_t dataOffset;
+			std::uint64_t dataSize;
+		};
+
+		const char packMagic[8] = { 'B', 'I', 'N', '2', 'C', 'P', 'K', '\0' };
+		const std::uint32_t packVersion = 1;
+
+		// 64-bit FNV-1a hash
+		std::uint64_t hashPackName(const char * name, size_t size) {
+			std::uint64_t hash = 14695981039346656037ULL;
+			for (size_t i = 0; i < size; ++i) {
+				hash = (hash ^ static_cast<unsigned char>(name[i])) * 1099511628211ULL;
+			}
+			return hash;
+		}
+	}
+
+	bool Pack::open(const char * path) {
+		close();
+#ifdef _WIN32
+		HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			return false;
+		}
+		LARGE_INTEGER fileSize;
+		HANDLE mappingHandle = nullptr;
+		if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart >= static_cast<LONGLONG>(sizeof(PackHeader))) {
+			mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		}
+		CloseHandle(file);
+		if (mappingHandle == nullptr) {
+			return false;
+		}
+		const void * view = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+		if (view == nullptr) {
+			CloseHandle(mappingHandle);
+			return false;
+		}
+		mapping = mappingHandle;
+		data = static_cast<const unsigned char *>(view);
+		dataSize = static_cast<size_t>(fileSize.QuadPart);
+#else
+		const int file = ::open(path, O_RDONLY);
+		if (file < 0) {
+			return false;
+		}
+		struct stat status;
+		void * view = MAP_FAILED;
+		if (fstat(file, &status) == 0 && status.st_size >= static_cast<off_t>(sizeof(PackHeader))) {
+			view = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_SHARED, file, 0);
+		}
+		::close(file);
+		if (view == MAP_FAILED) {
+			return false;
+		}
+		data = static_cast<const unsigned char *>(view);
+		dataSize = static_cast<size_t>(status.st_size);
+#endif
+
+		// the bounds of the tables, written without overflow for any header
+		const PackHeader & header = *reinterpret_cast<const PackHeader *>(data);
+		bool valid = std::memcmp(header.magic, packMagic, sizeof(packMagic)) == 0 &&
+			header.version == packVersion &&
+			header.packSize == dataSize &&
+			header.bucketCount != 0 && (header.bucketCount & (header.bucketCount - 1)) == 0 &&
+			header.bucketsOffset % 4 == 0 && header.bucketsOffset <= dataSize && header.bucketCount <= (dataSize - header.bucketsOffset) / 4 &&
+			header.entriesOffset % 8 == 0 && header.entriesOffset <= dataSize && header.fileCount <= (dataSize - header.entriesOffset) / sizeof(PackEntry) &&
+			header.namesOffset <= dataSize && header.namesSize <= dataSize - header.namesOffset;
+
+		// then the entries, so that the lookups can trust them: the names are null terminated in the name table
+		const PackEntry * entries = valid ? reinterpret_cast<const PackEntry *>(data + header.entriesOffset) : nullptr;
+		const char * names = reinterpret_cast<const char *>(data + header.namesOffset);
+		for (std::uint32_t i = 0; valid && i < header.fileCount; ++i) {
+			const PackEntry & entry = entries[i];
+			valid = static_cast<std::uint64_t>(entry.nameOffset) + entry.nameSize < header.namesSize &&
+				names[entry.nameOffset + entry.nameSize] == '\0' &&
+				entry.dataOffset <= dataSize && entry.dataSize <= dataSize - entry.dataOffset &&
+				entry.dataSize <= 0xFFFFFFFFULL;
+		}
+		if (!valid) {
+			close();
+		}
+		return valid;
+	}
+
+	void Pack::close() {
+		if (data != nullptr) {
+#ifdef _WIN32
+			UnmapViewOfFile(data);
+			CloseHandle(mapping);
+#else
+			munmap(const_cast<unsigned char *>(data), dataSize);
+#endif
+		}
+		data = nullptr;
+		dataSize = 0;
+		mapping = nullptr;
+	}
+
+	size_t Pack::size() const {
+		return data ? reinterpret_cast<const PackHeader *>(data)->fileCount : 0;
+	}
+
+	FileInfo Pack::operator[](size_t index) const {
+		const PackHeader & header = *reinterpret_cast<const PackHeader *>(data);
+		// validated by open()
+		const PackEntry & entry = reinterpret_cast<const PackEntry *>(data + header.entriesOffset)[index];
+		return FileInfo{
+			reinterpret_cast<const char *>(data + header.namesOffset + entry.nameOffset),
+			reinterpret_cast<const char *>(data + entry.dataOffset),
+			static_cast<unsigned int>(entry.dataSize),
+			FileInfo::noFileIndex
+		};
+	}
+
+	FileInfo Pack::find(const char * name) const {
+		if (data != nullptr) {
+			const PackHeader & header = *reinterpret_cast<const PackHeader *>(data);
+			const std::uint32_t * buckets = reinterpret_cast<const std::uint32_t *>(data + header.bucketsOffset);
+			const PackEntry * entries = reinterpret_cast<const PackEntry *>(data + header.entriesOffset);
+			const size_t nameSize = std::strlen(name);
+			const std::uint64_t hash = hashPackName(name, nameSize);
+			const std::uint32_t mask = header.bucketCount - 1;
+
+			// linear probing until an empty bucket
+			std::uint32_t bucket = static_cast<std::uint32_t>(hash) & mask;
+			for (std::uint32_t i = 0; i < header.bucketCount && buckets[bucket] != 0; ++i, bucket = (bucket + 1) & mask) {
+				const std::uint32_t index = buckets[bucket] - 1;
+				if (index < header.fileCount && entries[index].nameHash == hash && entries[index].nameSize == nameSize) {
+					const FileInfo file = (*this)[index];
+					if (std::memcmp(file.fileName, name, nameSize) == 0) {
+						return file;
+					}
+				}
+			}
+		}
+		return FileInfo{ nullptr, nullptr, 0, FileInfo::noFileIndex };
+	}
+)raw";
+
+	stream << s_packRuntime;
+}
+
+void generateVfsRuntime(std::ostream & stream) {
+	static const char * s_vfsRuntime = R"raw(
+	std::string VfsEntry::content() const {
+		if (path.empty()) {
+			return file.content();
+		}
+		std::ifstream input{ path, std::ios_base::in | std::ios_base::binary };
+		std::string content{ std::istreambuf_iterator<char>{ input }, std::istreambuf_iterator<char>{} };
+		if (!input.is_open() || input.bad()) {
+			// removed since the scan for instance: not an empty file
+			throw std::runtime_error{ "Failed to read file " + path };
+		}
+		return content;
+	}
+
+	Vfs::~Vfs() {
+#ifdef __linux__
+		if (watch >= 0) {
+			::close(watch);
+		}
+#endif
+	}
+
+	Vfs::Layer & Vfs::addLayer(int priority, const std::string & directory) {
+		layers.push_back(Layer{ priority, directory, std::vector<VfsEntry>{} });
+		return layers.back();
+	}
+
+	void Vfs::addDirectory(const std::string & path, int priority) {
+		addLayer(priority, path);
+	}
+
+	void Vfs::scanDirectory(Layer & layer, const std::string & path, const std::string & prefix, std::vector<std::pair<unsigned long long, unsigned long long>> & scanning) {
+#ifdef _WIN32
+		WIN32_FIND_DATAA item;
+		HANDLE search = FindFirstFileA((path + "\\*").c_str(), &item);
+		if (search == INVALID_HANDLE_VALUE) {
+			return;
+		}
+		do {
+			const std::string itemName = item.cFileName;
+			if (itemName == "." || itemName == "..") {
+				continue;
+			}
+			const std::string itemPath = path + '/' + itemName;
+			if ((item.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) && (item.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)) {
+				// junctions and symbolic links to directories aren't followed, they may loop
+				continue;
+			}
+			if (item.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+				scanDirectory(layer, itemPath, prefix + itemName + '/', scanning);
+			}
+			else {
+				layer.files.push_back(VfsEntry{ prefix + itemName, FileInfo{ nullptr, nullptr, 0, FileInfo::noFileIndex }, itemPath, layer.priority });
+			}
+		} while (FindNextFileA(search, &item));
+		FindClose(search);
+#else
+		// stat() follows the symbolic links: a link to a directory being scanned would recurse forever
+		struct stat directoryStatus;
+		if (stat(path.c_str(), &directoryStatus) != 0) {
+			return;
+		}
+		const std::pair<unsigned long long, unsigned long long> directoryId{ directoryStatus.st_dev, directoryStatus.st_ino };
+		if (std::find(scanning.begin(), scanning.end(), directoryId) != scanning.end()) {
+			return;
+		}
+		DIR * directory = opendir(path.c_str());
+		if (directory == nullptr) {
+			return;
+		}
+		scanning.push_back(directoryId);
+#ifdef __linux__
+		if (watch >= 0) {
+			// the content of the files is read on demand, only the changes of the names matter
+			inotify_add_watch(watch, path.c_str(), IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF);
+		}
+#endif
+		while (const dirent * item = readdir(directory)) {
+			const std::string itemName = item->d_name;
+			if (itemName == "." || itemName == "..") {
+				continue;
+			}
+			const std::string itemPath = path + '/' + itemName;
+			struct stat status;
+			if (stat(itemPath.c_str(), &status) != 0) {
+				continue;
+			}
+			if (S_ISDIR(status.st_mode)) {
+				scanDirectory(layer, itemPath, prefix + itemName + '/', scanning);
+			}
+			else if (S_ISREG(status.st_mode)) {
+				layer.files.push_back(VfsEntry{ prefix + itemName, FileInfo{ nullptr, nullptr, 0, FileInfo::noFileIndex }, itemPath, layer.priority });
+			}
+		}
+		scanning.pop_back();
+		closedir(directory);
+#endif
+	}
+
+	void Vfs::build() {
+#ifdef __linux__
+		if (watch >= 0) {
+			::close(watch);
+		}
+		watch = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+
+		// apply the layers by increasing priority, so the last one applied wins
+		std::vector<size_t> order;
+		for (size_t i = 0; i < layers.size(); ++i) {
+			order.push_back(i);
+		}
+		std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+			return layers[a].priority < layers[b].priority;
+		});
+
+		index.clear();
+		for (auto i : order) {
+			Layer & layer = layers[i];
+			if (!layer.directory.empty()) {
+				layer.files.clear();
+				std::vector<std::pair<unsigned long long, unsigned long long>> scanning;
+				scanDirectory(layer, layer.directory, std::string{}, scanning);
+			}
+			for (const auto & entry : layer.files) {
+				index[entry.name] = &entry;
+			}
+		}
+	}
+
+	bool Vfs::refresh() {
+#ifdef __linux__
+		if (watch >= 0) {
+			bool changed = false;
+			char events[4096];
+			while (::read(watch, events, sizeof(events)) > 0) {
+				changed = true;
+			}
+			if (!changed) {
+				return false;
+			}
+		}
+#endif
+		build();
+		return true;
+	}
+
+	const VfsEntry * Vfs::find(const std::string & name) const {
+		const auto entry = index.find(name);
+		return entry != index.end() ? entry->second : nullptr;
+	}
+)raw";
+
+	stream << s_vfsRuntime;
+}
+
+// An input file and how its data is written
+struct EmbeddedFile {
+	std::string path;
+	// data after the transforms (null if not transformed)
+	const std::string * transformedData;
+	unsigned long long size;
+	DataFormat format;
+	DataDigest digest;
+};
+
+// Name of the i-th shard: "generated.cpp" => "generated_<i>.cpp"
+std::string shardFileName(const Options & options, unsigned int shard) {
+	const fs::path cppFile{ options.cppFileName };
+	return cppFile.stem().generic_string() + "_" + std::to_string(shard) + cppFile.extension().generic_string();
+}
+
+// Write the data of the files in the shards, each shard being formatted and written by its own worker
+void generateShardFiles(const Options & options, Generator::Impl & generator, const std::vector<EmbeddedFile> & files,
+	const std::function<void(size_t, std::ostream &)> & writeFileData, OutputSink & sink, const Progress & progress) {
+	// contiguous ranges of files of about the same size
+	unsigned long long totalSize = 0;
+	for (const auto & file : files) {
+		totalSize += file.size;
+	}
+	std::vector<size_t> firstFiles(options.shardCount + 1, files.size());
+	unsigned long long position = 0;
+	for (size_t i = 0; i < files.size(); ++i) {
+		const size_t shard = totalSize == 0 ? i * options.shardCount / files.size() : static_cast<size_t>(position * options.shardCount / totalSize);
+		firstFiles[shard] = std::min(firstFiles[shard], i);
+		position += files[i].size;
+	}
+	// a shard without files starts where the next one starts
+	for (size_t shard = options.shardCount; shard-- > 0; ) {
+		firstFiles[shard] = std::min(firstFiles[shard], firstFiles[shard + 1]);
+	}
+
+	// the sink and the progress callbacks aren't required to be thread safe
+	std::mutex mutex;
+	std::string error;
+	generator.pool.parallelFor(options.shardCount, [&](size_t shard, unsigned int) {
+		try {
+			std::unique_lock<std::mutex> lock{ mutex };
+			OutputFile output{ shardFileName(options, static_cast<unsigned int>(shard)), sink, progress };
+			lock.unlock();
+
+			std::ostream & stream = output.stream();
+			stream << "// data of the files embedded by bin2cpp (shard " << shard + 1 << " of " << options.shardCount << ")\n";
+			stream << "\n";
+			if (!options.moduleName.empty()) {
+				// declared by the module implementation unit of the body
+				stream << "module " << options.moduleName << ";\n";
+				stream << "\n";
+			}
+			if (!options.namespaceName.empty()) {
+				stream << "namespace " << options.namespaceName << " {\n";
+			}
+			stream << "namespace shards {\n";
+			for (size_t i = firstFiles[shard]; i < firstFiles[shard + 1]; ++i) {
+				lock.lock();
+				notify(progress.onInputFile, files[i].path);
+				lock.unlock();
+				writeFileData(i, stream);
+			}
+			stream << "}\n";
+			if (!options.namespaceName.empty()) {
+				stream << "}\n";
+			}
+
+			lock.lock();
+			output.close();
+		}
+		catch (const std::exception & e) {
+			std::lock_guard<std::mutex> lock{ mutex };
+			error = e.what();
+		}
+	});
+
+	if (!error.empty()) {
+		throw std::runtime_error{ error };
+	}
+}
+
+// C++ identifier made of the given path: "input/config.json" => "input_config_json"
+std::string cppIdentifier(const std::string & path) {
+	std::string identifier;
+	for (char c : path) {
+		const bool valid = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+		identifier += valid ? c : '_';
+	}
+	if (identifier.empty() || (identifier[0] >= '0' && identifier[0] <= '9')) {
+		identifier = "_" + identifier;
+	}
+	return identifier;
+}
+
+// Name of the shared library of an asset group, without the platform prefix and extension: "<header base name>_<group>"
+std::string groupLibraryName(const Options & options, const std::string & group) {
+	return fs::path{ options.headerFileName }.stem().generic_string() + "_" + cppIdentifier(group);
+}
+
+// Exported function of the shared library of a group returning its files (unique in the process)
+std::string groupEntryPoint(const Options & options, const std::string & group) {
+	return "bin2cpp_group" + cppIdentifier(options.namespaceName + "_" + groupLibraryName(options, group));
+}
+
+// Files of the input list tagged with an asset group, the files being given to their first matching group
+std::map<std::string, std::vector<std::string>> groupFiles(const Options & options) {
+	std::map<std::string, std::vector<std::string>> groups;
+	for (auto path : options.inputFiles) {
+		for (auto group : options.libraryGroups) {
+			const bool tagged = std::any_of(options.tags.begin(), options.tags.end(), [&](const TagRule & rule) {
+				return rule.tag == group && matchGlob(rule.pattern, path);
+			});
+			if (tagged) {
+				groups[group].push_back(path);
+				break;
+			}
+		}
+	}
+	return groups;
+}
+
+// Generate the source of the shared library of an asset group: its files and the function returning them
+void generateGroupLibrary(const Options & options, const std::string & group, const std::vector<std::string> & files, const std::map<std::string, std::string> & transformedFiles, Generator::Impl & generator, OutputSink & sink, const Progress & progress) {
+	const CompilerCapabilities compiler = options.encoding == "auto" ?
+		generator.compilerCapabilities(options.compilerCommand, options.workDir) : s_portableCapabilities;
+	OutputFile output{ groupLibraryName(options, group) + ".cpp", sink, progress };
+	std::ostream & stream = output.stream();
+
+	stream << "// Files of the group " << cppStringLiteral(group) << ", to be built as a shared library loaded by loadGroup()\n";
+	stream << "#include \"" << options.headerFileName << "\"\n";
+	stream << "\n";
+	stream << "#ifdef _WIN32\n";
+	stream << "#define BIN2CPP_GROUP_EXPORT __declspec(dllexport)\n";
+	stream << "#else\n";
+	stream << "#define BIN2CPP_GROUP_EXPORT __attribute__((visibility(\"default\")))\n";
+	stream << "#endif\n";
+	stream << "\n";
+
+	stream << "namespace /* anonymous */ {\n";
+	for (size_t i = 0; i < files.size(); ++i) {
+		const std::string & path = files[i];
+		const std::string fileId = "file" + std::to_string(i);
+		notify(progress.onInputFile, path);
+		stream << "\tconst char * " << fileId << "_name = " << cppStringLiteral(path) << ";\n";
+		const auto transformed = transformedFiles.find(path);
+		if (transformed != transformedFiles.end()) {
+			const DataFormat format{ selectEncoding(options, compiler, transformed->second.size(), false), false, false, 0 };
+			std::istringstream data{ transformed->second };
+			convertDataToCppSource(fileId, data, transformed->second.size(), format, progress.counters, stream);
+		}
+		else if (options.archiveMembers.count(path)) {
+			const unsigned long long size = inputFileSize(options, path);
+			const DataFormat format{ selectEncoding(options, compiler, size, false), false, false, 0 };
+			convertDataToCppSource(fileId, *openInputFile(options, generator, path), size, format, progress.counters, stream);
+		}
+		else {
+			const DataFormat format{ selectEncoding(options, compiler, fs::file_size(path), true), false, false, 0 };
+			convertFileDataToCppSource(path, fileId, format, options.embedDirectory, progress.counters, stream);
+		}
+	}
+	stream << "}\n";
+	stream << "\n";
+
+	const std::string scope = options.namespaceName.empty() ? "" : options.namespaceName + "::";
+	stream << "namespace /* anonymous */ {\n";
+	if (files.empty()) {
+		stream << "\tconst " << scope << "FileInfo groupFiles[1] = {\n";
+		stream << "\t\t{ nullptr, nullptr, 0, " << scope << "FileInfo::noFileIndex },\n";
+	}
+	else {
+		stream << "\tconst " << scope << "FileInfo groupFiles[" << files.size() << "] = {\n";
+	}
+	for (size_t i = 0; i < files.size(); ++i) {
+		const std::string id = "file" + std::to_string(i);
+		stream << "\t\t{ " << id << "_name, reinterpret_cast<const char*>(" << id << "_data), " << id << "_data_size, " << scope << "FileInfo::noFileIndex },\n";
+	}
+	stream << "\t};\n";
+	stream << "}\n";
+	stream << "\n";
+	stream << "extern \"C\" BIN2CPP_GROUP_EXPORT const " << scope << "FileInfo * " << groupEntryPoint(options, group) << "(size_t * count) {\n";
+	stream << "\t*count = " << files.size() << ";\n";
+	stream << "\treturn groupFiles;\n";
+	stream << "}\n";
+	output.close();
+}
+
+// Generate loadGroup(), loading the shared libraries of the asset groups on demand
+void generateGroupLoaderRuntime(const Options & options, std::ostream & stream) {
+	static const char * s_groupLoaderRuntime = R"raw(
+	namespace /* anonymous */ {
+#if defined(_WIN32)
+		// LoadLibrary() only accepts backslashes in the paths
+		const char * groupLibraryPrefix = "";
+		const char * groupLibrarySuffix = ".dll";
+		const char * groupLibrarySeparator = "\\";
+#elif defined(__APPLE__)
+		const char * groupLibraryPrefix = "lib";
+		const char * groupLibrarySuffix = ".dylib";
+		const char * groupLibrarySeparator = "/";
+#else
+		const char * groupLibraryPrefix = "lib";
+		const char * groupLibrarySuffix = ".so";
+		const char * groupLibrarySeparator = "/";
+#endif
+		std::string groupLibraryDirectory;
+
+		typedef const FileInfo * (*GroupEntryPoint)(size_t * count);
+
+		void loadGroupLibrary(GroupLibrary & library) {
+			std::string path = groupLibraryPrefix + std::string{ library.baseName } + groupLibrarySuffix;
+			if (!groupLibraryDirectory.empty()) {
+				path = groupLibraryDirectory + groupLibrarySeparator + path;
+			}
+#ifdef _WIN32
+			HMODULE module = LoadLibraryA(path.c_str());
+			const auto entryPoint = module ? reinterpret_cast<GroupEntryPoint>(GetProcAddress(module, library.entryPoint)) : nullptr;
+#else
+			void * module = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+			const auto entryPoint = module ? reinterpret_cast<GroupEntryPoint>(dlsym(module, library.entryPoint)) : nullptr;
+#endif
+			if (entryPoint != nullptr) {
+				size_t count = 0;
+				library.files.first = entryPoint(&count);
+				library.files.count = count;
+			}
+		}
+	}
+
+	GroupFileRange loadGroup(const std::string & group) {
+		for (auto & library : groupLibraries) {
+			if (group == library.name) {
+				std::call_once(library.loaded, [&library]() { loadGroupLibrary(library); });
+				return library.files;
+			}
+		}
+		return GroupFileRange{ nullptr, 0 };
+	}
+
+	void setGroupLibraryDirectory(const std::string & directory) {
+		groupLibraryDirectory = directory;
+	}
+)raw";
+
+	stream << "\n";
+	stream << "\tnamespace /* anonymous */ {\n";
+	stream << "\t\tstruct GroupLibrary {\n";
+	stream << "\t\t\tconst char * name;\n";
+	stream << "\t\t\t// file name without the platform prefix and extension\n";
+	stream << "\t\t\tconst char * baseName;\n";
+	stream << "\t\t\tconst char * entryPoint;\n";
+	stream << "\t\t\tstd::once_flag loaded;\n";
+	stream << "\t\t\tGroupFileRange files;\n";
+	stream << "\t\t};\n";
+	stream << "\n";
+	stream << "\t\tGroupLibrary groupLibraries[] = {\n";
+	for (auto group : options.libraryGroups) {
+		stream << "\t\t\t{ " << cppStringLiteral(group) << ", " << cppStringLiteral(groupLibraryName(options, group)) << ", "
+			<< cppStringLiteral(groupEntryPoint(options, group)) << ", {}, { nullptr, 0 } },\n";
+	}
+	stream << "\t\t};\n";
+	stream << "\t}\n";
+	stream << s_groupLoaderRuntime;
+}
+
+// Generate the entry registering the bundle in the section collected by the linker
+void generateRegistryEntry(const Options & options, std::ostream & stream) {
+	static const char * s_registryEntry = R"raw(
+	namespace /* anonymous */ {
+		void getRegisteredFile(size_t index, std::string & name, const char * & data, size_t & size) {
+			name = fileInfoList[index].name();
+			data = fileInfoList[index].fileData;
+			size = fileInfoList[index].fileDataSize;
+		}
+)raw";
+
+	stream << s_registryEntry;
+	stream << "\n";
+	stream << "\t\tconst bin2cpp::RegisteredBundle registeredBundle{ " << cppStringLiteral(options.namespaceName) << ", "
+		<< options.inputFiles.size() << ", getRegisteredFile };\n";
+	stream << "\t}\n";
+	// with external linkage, so that the linker can be told to keep it
+	const std::string registration = "bin2cpp_registration" + (options.namespaceName.empty() ? "" : "_" + cppIdentifier(options.namespaceName));
+	stream << "\textern \"C\" BIN2CPP_REGISTRY_ENTRY BIN2CPP_REGISTRY_LOCAL const bin2cpp::RegisteredBundle * const " << registration << " = &registeredBundle;\n";
+	stream << "\tBIN2CPP_REGISTRY_KEEP(" << registration << ")\n";
+}
+
+void generateLazyDecodeRuntime(std::ostream & stream) {
+	static const char * s_lazyDecodeRuntime = R"raw(
+	namespace /* anonymous */ {
+		// Content of a file whose blocks are decoded on their first access
+		struct LazyRange {
+			char * data;
+			size_t size;
+			size_t blockSize;
+			// copied: the faults are handled long after lazyDecode() returned
+			const FileInfo file;
+			BlockDecoder decode;
+		};
+
+		void decodeBlock(const LazyRange & range, size_t block, char * output) {
+			const size_t offset = block * range.blockSize;
+			range.decode(range.file, block, output, std::min(range.blockSize, range.size - offset));
+		}
+
+		const char * decodeEagerly(const FileInfo & file, size_t decodedSize, size_t blockSize, const BlockDecoder & decode) {
+			// never released, as the lazily decoded contents
+			const LazyRange range{ new char[decodedSize > 0 ? decodedSize : 1], decodedSize, blockSize, file, decode };
+			try {
+				for (size_t block = 0; block * blockSize < decodedSize; ++block) {
+					decodeBlock(range, block, range.data + block * blockSize);
+				}
+			}
+			catch (...) {
+				delete[] range.data;
+				throw;
+			}
+			return range.data;
+		}
+
+#ifdef __linux__
+		// Reserves the ranges of the lazily decoded contents and fills their missing pages from a userfaultfd handler thread
+		class LazyDecoder {
+		public:
+			static LazyDecoder & instance() {
+				// never destroyed: the handler thread runs until the end of the program
+				static LazyDecoder * decoder = new LazyDecoder;
+				return *decoder;
+			}
+
+			bool available() const {
+				return fd >= 0;
+			}
+
+			// Reserve the range of a content (nullptr if it can't be decoded lazily)
+			const char * map(const FileInfo & file, size_t decodedSize, size_t blockSize, const BlockDecoder & decode) {
+				const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+				if (fd < 0 || decodedSize == 0 || blockSize == 0 || blockSize % pageSize != 0) {
+					return nullptr;
+				}
+				const size_t size = (decodedSize + pageSize - 1) / pageSize * pageSize;
+				void * data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+				if (data == MAP_FAILED) {
+					return nullptr;
+				}
+				uffdio_register registration{};
+				registration.range.start = reinterpret_cast<std::uintptr_t>(data);
+				registration.range.len = size;
+				registration.mode = UFFDIO_REGISTER_MODE_MISSING;
+				if (ioctl(fd, UFFDIO_REGISTER, &registration) != 0) {
+					munmap(data, size);
+					return nullptr;
+				}
+				std::lock_guard<std::mutex> lock{ mutex };
+				ranges.push_back(LazyRange{ static_cast<char *>(data), decodedSize, blockSize, file, decode });
+				return static_cast<const char *>(data);
+			}
+
+		private:
+			LazyDecoder() {
+				// UFFD_USER_MODE_ONLY isn't used when this fails: the faults of the system calls wouldn't be handled
+				fd = static_cast<int>(syscall(SYS_userfaultfd, O_CLOEXEC | O_NONBLOCK));
+				uffdio_api api{};
+				api.api = UFFD_API;
+				if (fd >= 0 && ioctl(fd, UFFDIO_API, &api) != 0) {
+					close(fd);
+					fd = -1;
+				}
+				if (fd >= 0) {
+					std::thread{ [this]() { run(); } }.detach();
+				}
+			}
+
+			void run() {
+				std::vector<char> buffer;
+				for (;;) {
+					pollfd event{ fd, POLLIN, 0 };
+					uffd_msg message;
+					if (poll(&event, 1, -1) <= 0 || read(fd, &message, sizeof(message)) != sizeof(message) || message.event != UFFD_EVENT_PAGEFAULT) {
+						continue;
+					}
+					const auto address = static_cast<std::uintptr_t>(message.arg.pagefault.address);
+					const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+					// the ranges are never removed, and keep their address in the deque
+					const LazyRange * found = nullptr;
+					{
+						std::lock_guard<std::mutex> lock{ mutex };
+						for (const auto & candidate : ranges) {
+							const auto start = reinterpret_cast<std::uintptr_t>(candidate.data);
+							if (address >= start && address - start < candidate.size + pageSize - 1) {
+								found = &candidate;
+								break;
+							}
+						}
+					}
+					if (found == nullptr) {
+						continue;
+					}
+					const LazyRange & range = *found;
+
+					// the whole block is decoded (padded with zeros to the end of its last page)
+					const size_t block = (address - reinterpret_cast<std::uintptr_t>(range.data)) / range.blockSize;
+					const size_t offset = block * range.blockSize;
+					const size_t pagedSize = (range.size + pageSize - 1) / pageSize * pageSize;
+					buffer.assign(std::min(range.blockSize, pagedSize - offset), 0);
+					try {
+						decodeBlock(range, block, buffer.data());
+					}
+					catch (...) {
+						// the faulting thread must be woken up: the block is left filled with zeros
+						buffer.assign(buffer.size(), 0);
+					}
+					uffdio_copy copy{};
+					copy.dst = reinterpret_cast<std::uintptr_t>(range.data + offset);
+					copy.src = reinterpret_cast<std::uintptr_t>(buffer.data());
+					copy.len = buffer.size();
+					// fails with EEXIST if the block was already decoded for another fault, whose thread is then awake
+					ioctl(fd, UFFDIO_COPY, &copy);
+				}
+			}
+
+			int fd = -1;
+			std::mutex mutex;
+			std::deque<LazyRange> ranges;
+		};
+#endif
+	}
+
+	const char * lazyDecode(const FileInfo & file, size_t decodedSize, size_t blockSize, BlockDecoder decode) {
+#ifdef __linux__
+		if (const char * data = LazyDecoder::instance().map(file, decodedSize, blockSize, decode)) {
+			return data;
+		}
+#endif
+		return decodeEagerly(file, decodedSize, blockSize, decode);
+	}
+
+	bool lazyDecodeSupported() {
+#ifdef __linux__
+		return LazyDecoder::instance().available();
+#else
+		return false;
+#endif
+	}
+)raw";
+
+	stream << s_lazyDecodeRuntime;
+}
+
+void generateSharedCacheRuntime(unsigned long long bundleHash, std::ostream & stream) {
+	static const char * s_sharedCacheRuntime = R"raw(
+	namespace /* anonymous */ {
+		// value of the first 8 bytes of a segment once its content is complete
+		const std::uint64_t sharedContentReady = 0x4e4950324e494231ULL;
+
+		// name of the segment: hash of the bundle, of the file, of the decoder (and of the user on POSIX systems)
+		std::string sharedContentName(const FileInfo & file, const char * decoderName) {
+			std::uint64_t hash = sharedBundleHash;
+			auto mix = [&hash](const char * data, size_t size) {
+				for (size_t i = 0; i < size; ++i) {
+					hash = (hash ^ static_cast<unsigned char>(data[i])) * 1099511628211ULL;
+				}
+			};
+			const std::uint64_t index = embeddedIndex(file);
+			mix(reinterpret_cast<const char *>(&index), sizeof(index));
+			mix(decoderName, std::strlen(decoderName) + 1);
+#ifndef _WIN32
+			const std::uint64_t user = geteuid();
+			mix(reinterpret_cast<const char *>(&user), sizeof(user));
+#endif
+
+			// short enough for all the systems (31 characters on macOS)
+			static const char * digits = "0123456789abcdef";
+			std::string name = "bin2cpp-";
+			for (int shift = 60; shift >= 0; shift -= 4) {
+				name += digits[(hash >> shift) & 0xF];
+			}
+			return name;
+		}
+
+		// Lock serializing the processes decoding the same file (released if the process dies)
+		class SharedContentLock {
+		public:
+			explicit SharedContentLock(const std::string & name) {
+#ifdef _WIN32
+				handle = CreateMutexA(nullptr, FALSE, ("Local\\" + name + "-lock").c_str());
+				if (handle != nullptr) {
+					// WAIT_ABANDONED also gives the ownership
+					WaitForSingleObject(handle, INFINITE);
+				}
+#else
+				// in a directory of the user, so that the other users can't create or replace the lock files
+				const char * tempDir = std::getenv("TMPDIR");
+				const std::string directory = std::string{ tempDir && *tempDir ? tempDir : "/tmp" } + "/bin2cpp-" + std::to_string(geteuid());
+				struct stat status;
+				mkdir(directory.c_str(), 0700);
+				if (lstat(directory.c_str(), &status) != 0 || !S_ISDIR(status.st_mode) || status.st_uid != geteuid() || (status.st_mode & 077) != 0) {
+					// not locked: the processes racing to publish the content decode it locally
+					return;
+				}
+				path = directory + "/" + name + ".lock";
+				for (;;) {
+					file = ::open(path.c_str(), O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC, 0600);
+					if (file < 0 || flock(file, LOCK_EX) != 0) {
+						break;
+					}
+					// the previous owner removes the file: the lock only counts if it's still the file of the path
+					struct stat locked;
+					if (fstat(file, &locked) == 0 && ::stat(path.c_str(), &status) == 0 && locked.st_dev == status.st_dev && locked.st_ino == status.st_ino) {
+						return;
+					}
+					::close(file);
+				}
+				if (file >= 0) {
+					::close(file);
+					file = -1;
+				}
+#endif
+			}
+			~SharedContentLock() {
+#ifdef _WIN32
+				if (handle != nullptr) {
+					ReleaseMutex(handle);
+					CloseHandle(handle);
+				}
+#else
+				if (file >= 0) {
+					// removed before being unlocked, the waiting processes then create a new one
+					::unlink(path.c_str());
+					flock(file, LOCK_UN);
+					::close(file);
+				}
+#endif
+			}
+			SharedContentLock(const SharedContentLock &) = delete;
+			SharedContentLock & operator=(const SharedContentLock &) = delete;
+
+		private:
+#ifdef _WIN32
+			HANDLE handle = nullptr;
+#else
+			std::string path;
+			int file = -1;
+#endif
+		};
+	}
+
+	SharedContent::SharedContent(SharedContent && other) {
+		*this = std::move(other);
+	}
+
+	SharedContent & SharedContent::operator=(SharedContent && other) {
+		if (this != &other) {
+			release();
+			view = other.view;
+			viewSize = other.viewSize;
+			mapping = other.mapping;
+			local = std::move(other.local);
+			contentSize = other.contentSize;
+			other.view = nullptr;
+			other.viewSize = 0;
+			other.mapping = nullptr;
+			other.contentSize = 0;
+		}
+		return *this;
+	}
+
+	SharedContent::~SharedContent() {
+		release();
+	}
+
+	void SharedContent::release() {
+		if (view != nullptr) {
+#ifdef _WIN32
+			UnmapViewOfFile(view);
+			CloseHandle(mapping);
+#else
+			munmap(const_cast<char *>(view), viewSize);
+#endif
+		}
+		view = nullptr;
+		mapping = nullptr;
+	}
+
+	SharedContent sharedDecode(const FileInfo & file, const char * decoderName, const std::function<std::string(const FileInfo &)> & decode) {
+		SharedContent content;
+		if (embeddedIndex(file) == FileInfo::noFileIndex) {
+			// not a file of the bundle, nothing identifies it in the other processes
+			content.local = decode(file);
+			content.contentSize = content.local.size();
+			return content;
+		}
+		const std::string name = sharedContentName(file, decoderName);
+		SharedContentLock lock{ name };
+
+#ifdef _WIN32
+		const std::string mappingName = "Local\\" + name;
+		HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, mappingName.c_str());
+		if (mapping == nullptr) {
+			// first process: publish the decoded content
+			content.local = decode(file);
+			const std::uint64_t size = SharedContent::headerSize + content.local.size();
+			mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+				static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), mappingName.c_str());
+			void * view = mapping ? MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0) : nullptr;
+			if (view == nullptr) {
+				if (mapping != nullptr) {
+					CloseHandle(mapping);
+				}
+				content.contentSize = content.local.size();
+				return content;
+			}
+			char * data = static_cast<char *>(view);
+			const std::uint64_t contentSize = content.local.size();
+			std::memcpy(data + 8, &contentSize, sizeof(contentSize));
+			std::memcpy(data + SharedContent::headerSize, content.local.data(), content.local.size());
+			std::memcpy(data, &sharedContentReady, sizeof(sharedContentReady));
+			UnmapViewOfFile(view);
+		}
+
+		const char * view = static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		std::uint64_t ready = 0;
+		std::uint64_t contentSize = 0;
+		if (view != nullptr) {
+			std::memcpy(&ready, view, sizeof(ready));
+			std::memcpy(&contentSize, view + 8, sizeof(contentSize));
+		}
+		if (ready != sharedContentReady) {
+			// the process publishing it failed, decode it here
+			if (view != nullptr) {
+				UnmapViewOfFile(view);
+			}
+			CloseHandle(mapping);
+			if (content.local.empty()) {
+				content.local = decode(file);
+			}
+			content.contentSize = content.local.size();
+			return content;
+		}
+		content.view = view;
+		content.mapping = mapping;
+#else
+		// the segment names are predictable: only the segments created by this user and that only this user can write are used
+		auto trusted = [](int segment, struct stat & status) {
+			return fstat(segment, &status) == 0 && status.st_uid == geteuid() && (status.st_mode & 022) == 0;
+		};
+		const std::string segmentName = "/" + name;
+		int segment = shm_open(segmentName.c_str(), O_RDONLY, 0);
+		struct stat status;
+		if (segment >= 0 && !trusted(segment, status)) {
+			// created by another user: decoded here, without sharing it
+			::close(segment);
+			content.local = decode(file);
+			content.contentSize = content.local.size();
+			return content;
+		}
+		std::uint64_t ready = 0;
+		if (segment >= 0 && status.st_size >= static_cast<off_t>(SharedContent::headerSize)) {
+			if (pread(segment, &ready, sizeof(ready), 0) != static_cast<ssize_t>(sizeof(ready))) {
+				ready = 0;
+			}
+		}
+		if (segment >= 0 && ready != sharedContentReady) {
+			// left incomplete by a process which died while publishing it
+			::close(segment);
+			shm_unlink(segmentName.c_str());
+			segment = -1;
+		}
+
+		if (segment < 0) {
+			// first process: publish the decoded content
+			content.local = decode(file);
+			const int created = shm_open(segmentName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+			const size_t size = SharedContent::headerSize + content.local.size();
+			void * view = MAP_FAILED;
+			if (created >= 0 && ftruncate(created, static_cast<off_t>(size)) == 0) {
+				view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, created, 0);
+			}
+			if (view == MAP_FAILED) {
+				if (created >= 0) {
+					::close(created);
+					shm_unlink(segmentName.c_str());
+				}
+				content.contentSize = content.local.size();
+				return content;
+			}
+			char * data = static_cast<char *>(view);
+			const std::uint64_t contentSize = content.local.size();
+			std::memcpy(data + 8, &contentSize, sizeof(contentSize));
+			std::memcpy(data + SharedContent::headerSize, content.local.data(), content.local.size());
+			std::memcpy(data, &sharedContentReady, sizeof(sharedContentReady));
+			munmap(view, size);
+			::close(created);
+			segment = shm_open(segmentName.c_str(), O_RDONLY, 0);
+			if (segment < 0 || !trusted(segment, status)) {
+				if (segment >= 0) {
+					::close(segment);
+				}
+				content.contentSize = content.local.size();
+				return content;
+			}
+		}
+
+		const size_t size = static_cast<size_t>(status.st_size);
+		void * view = mmap(nullptr, size, PROT_READ, MAP_SHARED, segment, 0);
+		::close(segment);
+		if (view == MAP_FAILED) {
+			if (content.local.empty()) {
+				content.local = decode(file);
+			}
+			content.contentSize = content.local.size();
+			return content;
+		}
+		content.view = static_cast<const char *>(view);
+		content.viewSize = size;
+		std::uint64_t contentSize = 0;
+		std::memcpy(&contentSize, content.view + 8, sizeof(contentSize));
+#endif
+		// the content is now shared
+		content.local.clear();
+		content.local.shrink_to_fit();
+		content.contentSize = static_cast<size_t>(contentSize);
+		return content;
+	}
+
+	void removeSharedContent(const FileInfo & file, const char * decoderName) {
+#ifndef _WIN32
+		if (embeddedIndex(file) == FileInfo::noFileIndex) {
+			return;
+		}
+		const std::string name = sharedContentName(file, decoderName);
+		SharedContentLock lock{ name };
+		shm_unlink(("/" + name).c_str());
+#else
+		(void)file;
+		(void)decoderName;
+#endif
+	}
+)raw";
+
+	std::ios::fmtflags flags(stream.flags());
+	stream << "\n";
+	stream << "\tnamespace /* anonymous */ {\n";
+	stream << "\t\tconst unsigned long long sharedBundleHash = 0x" << std::hex << bundleHash << "ULL;\n";
+	stream << "\t}\n";
+	stream.flags(flags);
+	stream << s_sharedCacheRuntime;
+}
+
+void generateBodyFile(const Options & options, const std::map<std::string, std::string> & transformedFiles, Generator::Impl & generator, OutputSink & sink, const Progress & progress) {
+	const CompilerCapabilities compiler = options.encoding == "auto" ?
+		generator.compilerCapabilities(options.compilerCommand, options.workDir) : s_portableCapabilities;
+
+	// choose how to write each file
+	std::vector<EmbeddedFile> files;
+	for (auto path : options.inputFiles) {
+		const auto transformed = transformedFiles.find(path);
+		const bool isTransformed = transformed != transformedFiles.end();
+		const unsigned long long size = isTransformed ? transformed->second.size() : inputFileSize(options, path);
+		const bool onDisk = !isTransformed && !options.archiveMembers.count(path);
+		const DataFormat format{ selectEncoding(options, compiler, size, onDisk), options.shardCount > 1,
+			options.contentHashIndex || options.crcBlockSize != 0 || options.generateSharedCache, options.crcBlockSize };
+		files.push_back(EmbeddedFile{ path, isTransformed ? &transformed->second : nullptr, size, format, DataDigest{ 0, 0 } });
+	}
+
+	// may be called from the shard workers, each file being written once
+	auto writeFileData = [&](size_t i, std::ostream & dataStream) {
+		EmbeddedFile & file = files[i];
+		const std::string fileId = "file" + std::to_string(i);
+		if (file.transformedData) {
+			std::istringstream data{ *file.transformedData };
+			file.digest = convertDataToCppSource(fileId, data, file.size, file.format, progress.counters, dataStream);
+		}
+		else if (options.archiveMembers.count(file.path)) {
+			file.digest = convertDataToCppSource(fileId, *openInputFile(options, generator, file.path), file.size, file.format, progress.counters, dataStream);
+		}
+		else {
+			file.digest = convertFileDataToCppSource(file.path, fileId, file.format, options.embedDirectory, progress.counters, dataStream);
+		}
+	};
+
+	if (options.shardCount > 1) {
+		generateShardFiles(options, generator, files, writeFileData, sink, progress);
+	}
+
+	OutputFile output{ options.cppFileName, sink, progress };
+	std::ostream & stream = output.stream();
+
+	const bool moduleUnit = !options.moduleName.empty();
+	if (moduleUnit) {
+		// a module implementation unit: the API is declared by the module interface unit
+		stream << "module;\n";
+		stream << "\n";
+		writeApiIncludes(options, stream);
+	}
+	else {
+		stream << "#include \"" << options.headerFileName << "\"\n";
+	}
+	stream << "\n";
+	stream << "#include <algorithm>\n";
+	if (options.crcBlockSize != 0) {
+		stream << "#include <atomic>\n";
+	}
+	// worker threads of the runtimes
+	const bool threads = options.generatePreload || options.crcBlockSize != 0 || options.generateAsyncApi || options.generateLazyDecode;
+	if (options.generatePreload || options.crcBlockSize != 0 || options.generateAsyncApi) {
+		stream << "#include <condition_variable>\n";
+	}
+	if (!options.packFileName.empty() || options.crcBlockSize != 0 || options.generateSharedCache || options.generateLazyDecode) {
+		stream << "#include <cstdint>\n";
+	}
+	if (options.generateSharedCache) {
+		stream << "#include <cstdlib>\n";
+	}
+	stream << "#include <cstring>\n";
+	if (options.generateAsyncApi || options.generateLazyDecode) {
+		stream << "#include <deque>\n";
+	}
+	if (options.generateVfs) {
+		stream << "#include <fstream>\n";
+		stream << "#include <iterator>\n";
+	}
+	if (options.generateAsyncApi) {
+		stream << "#include <memory>\n";
+	}
+	if (threads || !options.libraryGroups.empty()) {
+		stream << "#include <mutex>\n";
+	}
+	if (options.crcBlockSize != 0 || options.generateVfs) {
+		stream << "#include <stdexcept>\n";
+	}
+	if (threads) {
+		stream << "#include <thread>\n";
+	}
+	stream << "#include <vector>\n";
+	if (options.crcBlockSize != 0) {
+		stream << "\n";
+		stream << "#if defined(_M_X64)\n";
+		stream << "#include <intrin.h>\n";
+		stream << "#elif defined(__x86_64__)\n";
+		stream << "#include <nmmintrin.h>\n";
+		stream << "#endif\n";
+	}
+	if (!options.packFileName.empty() || options.generateVfs || options.generateSharedCache || options.generateLazyDecode || !options.libraryGroups.empty()) {
+		stream << "\n";
+		stream << "#ifdef _WIN32\n";
+		stream << "#define WIN32_LEAN_AND_MEAN\n";
+		stream << "#define NOMINMAX\n";
+		stream << "#include <windows.h>\n";
+		stream << "#else\n";
+		if (options.generateVfs) {
+			stream << "#include <dirent.h>\n";
+		}
+		if (!options.packFileName.empty() || options.generateSharedCache || options.generateLazyDecode) {
+			stream << "#include <fcntl.h>\n";
+		}
+		if (!options.libraryGroups.empty()) {
+			stream << "#include <dlfcn.h>\n";
+		}
+		if (options.generateSharedCache) {
+			stream << "#include <sys/file.h>\n";
+		}
+		if (!options.packFileName.empty() || options.generateSharedCache || options.generateLazyDecode) {
+			stream << "#include <sys/mman.h>\n";
+		}
+		stream << "#include <sys/stat.h>\n";
+		stream << "#include <unistd.h>\n";
+		if (options.generateVfs || options.generateLazyDecode) {
+			stream << "#ifdef __linux__\n";
+			if (options.generateLazyDecode) {
+				stream << "#include <linux/userfaultfd.h>\n";
+				stream << "#include <poll.h>\n";
+				stream << "#include <sys/ioctl.h>\n";
+			}
+			if (options.generateVfs) {
+				stream << "#include <sys/inotify.h>\n";
+			}
+			if (options.generateLazyDecode) {
+				stream << "#include <sys/syscall.h>\n";
+			}
+			stream << "#endif\n";
+		}
+		stream << "#endif\n";
+	}
+	stream << "\n";
+	if (moduleUnit) {
+		stream << "module " << options.moduleName << ";\n";
+		stream << "\n";
+	}
+
+	const bool sharded = options.shardCount > 1;
+	if (sharded) {
+		// the data is defined in the shards
+		if (!options.namespaceName.empty()) {
+			stream << "namespace " << options.namespaceName << " {\n";
+		}
+		stream << "\tnamespace shards {\n";
+		for (size_t i = 0; i < files.size(); ++i) {
+			stream << "\t\textern const unsigned char file" << i << "_data[];\n";
+		}
+		stream << "\t}\n";
+		if (!options.namespaceName.empty()) {
+			stream << "}\n";
+		}
+		stream << "\n";
+	}
+
+	stream << "namespace /* anonymous */ {\n";
+	for (size_t i = 0; i < files.size(); ++i) {
+		const std::string fileId = "file" + std::to_string(i);
+		if (!options.frontCodedNames) {
+			stream << "\tconst char * " << fileId << "_name = " << cppStringLiteral(files[i].path) << ";\n";
+		}
+		if (sharded) {
+			stream << "\tconst unsigned int " << fileId << "_data_size = " << files[i].size << ";\n";
+		}
+		else {
+			notify(progress.onInputFile, files[i].path);
+			writeFileData(i, stream);
+		}
+	}
+	stream << "}\n";
+	stream << "\n";
+
+	if (options.encoding == "auto") {
+		std::map<std::string, unsigned int> encodingCounts;
+		for (const auto & file : files) {
+			encodingCounts[file.format.encoding] += 1;
+		}
+		std::string stats = "Encodings:";
+		for (const auto & count : encodingCounts) {
+			stats += " " + std::to_string(count.second) + " " + count.first;
+		}
+		notify(progress.onMessage, stats);
+	}
+
+	if (!options.namespaceName.empty()) {
+		stream << "namespace " << options.namespaceName << " {\n";
+	}
+	stream << "\tconst unsigned int fileInfoListSize = " << files.size() << ";\n";
+	if (files.empty()) {
+		// C++ forbids empty arrays
+		stream << "\tconst FileInfo fileInfoList[1] = {\n";
+		stream << "\t\t{ nullptr, nullptr, 0, FileInfo::noFileIndex },\n";
+	}
+	else {
+		stream << "\tconst FileInfo fileInfoList[fileInfoListSize] = {\n";
+	}
+	for (size_t i = 0; i < files.size(); ++i) {
+		const std::string id = "file" + std::to_string(i);
+		const std::string name = options.frontCodedNames ? "nullptr" : id + "_name";
+		const std::string data = (sharded ? "shards::" : "") + id + "_data";
+		stream << "\t\t{ " << name << ", reinterpret_cast<const char*>(" << data << "), " << id << "_data_size, " << i << " },\n";
+	}
+	stream << "\t};\n";
+
+	generateNameLookup(options, stream);
+	if (options.normalizedIndex) {
+		generateNormalizedIndex(options, stream);
+	}
+	if (options.extensionIndex || !options.tags.empty()) {
+		generateGroupIndexes(options, stream);
+	}
+	if (options.contentHashIndex) {
+		std::vector<unsigned long long> contentHashes;
+		for (const auto & file : files) {
+			contentHashes.push_back(file.digest.hash);
+		}
+		generateContentHashIndex(contentHashes, stream);
+	}
+	if (options.crcBlockSize != 0) {
+		std::vector<DataDigest> digests;
+		for (const auto & file : files) {
+			digests.push_back(file.digest);
+		}
+		generateIntegrityRuntime(options, digests, stream);
+	}
+
+	if (options.generatePreload) {
+		generatePreloadRuntime(options, stream);
+	}
+	if (options.generateAsyncApi) {
+		generateAsyncRuntime(stream);
+	}
+	if (!options.packFileName.empty()) {
+		generatePackRuntime(stream);
+	}
+	if (options.generateVfs) {
+		generateVfsRuntime(stream);
+	}
+	if (options.generateSharedCache) {
+		// identifies the content of the bundle in the names of the shared memory segments
+		unsigned long long bundleHash = hashData(std::string{});
+		for (const auto & file : files) {
+			bundleHash = hashData(file.path + '\0' + std::to_string(file.digest.hash) + '\0', bundleHash);
+		}
+		generateSharedCacheRuntime(bundleHash, stream);
+	}
+	if (options.generateLazyDecode) {
+		generateLazyDecodeRuntime(stream);
+	}
+	if (!options.libraryGroups.empty()) {
+		generateGroupLoaderRuntime(options, stream);
+	}
+	if (options.registerBundle) {
+		generateRegistryEntry(options, stream);
+	}
+	if (!options.namespaceName.empty()) {
+		stream << "}\n";
+	}
+	output.close();
+}
+
+// Generate a header exposing the content of the selected files as constexpr string views (C++17),
+// so they can be parsed in constant expressions
+void generateConstexprHeader(const Options & options, const std::map<std::string, std::string> & transformedFiles, Generator::Impl & generator, const std::string & headerFileName, OutputSink & sink, const Progress & progress) {
+	OutputFile output{ headerFileName, sink, progress };
+	std::ostream & stream = output.stream();
+
+	stream << "#pragma once\n";
+	stream << "\n";
+	stream << "#include <string_view>\n";
+	stream << "\n";
+	stream << "// Content of the files selected with -constexpr, usable in constant expressions\n";
+	if (!options.namespaceName.empty()) {
+		stream << "namespace " << options.namespaceName << " {\n";
+	}
+	stream << "\tnamespace constexprFiles {\n";
+
+	std::set<std::string> identifiers;
+	for (auto path : options.inputFiles) {
+		const bool selected = std::any_of(options.constexprPatterns.begin(), options.constexprPatterns.end(), [&](const std::string & pattern) {
+			return matchGlob(pattern, path);
+		});
+		if (!selected) {
+			continue;
+		}
+
+		const auto transformed = transformedFiles.find(path);
+		if ((transformed != transformedFiles.end() ? transformed->second.size() : inputFileSize(options, path)) >= s_portableCapabilities.maxStringSize) {
+			throw std::runtime_error{ "File too large for a constexpr string literal: " + path };
+		}
+		const std::string data = transformed != transformedFiles.end() ? transformed->second : readInputFile(options, generator, path);
+
+		// names made of different paths may collide ("a-b" and "a_b")
+		std::string identifier = cppIdentifier(path);
+		for (unsigned int i = 2; !identifiers.insert(identifier).second; ++i) {
+			identifier = cppIdentifier(path) + "_" + std::to_string(i);
+		}
+
+		std::istringstream input{ data };
+		DataDigest digest{ data.size(), 0 };
+		stream << "\t\t// " << path << "\n";
+		stream << "\t\tinline constexpr std::string_view " << identifier << "{";
+		// the view covers the whole literal, so it can't end before the trailing zeros
+		// (not counted in the progress, the data is also written in the .cpp file)
+		DataCounter counter{ nullptr };
+		writeStringData(input, std::vector<DataSegment>{ DataSegment{ 0, data.size(), false } }, digest, counter, stream);
+		stream << ", " << data.size() << " };\n";
+	}
+
+	stream << "\t}\n";
+	if (!options.namespaceName.empty()) {
+		stream << "}\n";
+	}
+	output.close();
+}
+
+// Generate a module interface unit declaring the generated API in its purview, so it's parsed once per build
+// instead of once per translation unit. The body is then a module implementation unit.
+void generateModuleFile(const Options & options, const std::string & moduleFileName, OutputSink & sink, const Progress & progress) {
+	if (options.registerBundle) {
+		// the registry is shared by all the bundles, its header is included next to the import
+		OutputFile registry{ registryHeaderFileName(options), sink, progress };
+		registry.stream() << "#pragma once\n";
+		registry.stream() << "\n";
+		registry.stream() << "#include <string>\n";
+		writeRegistryDeclarations(registry.stream());
+		registry.close();
+	}
+
+	OutputFile output{ moduleFileName, sink, progress };
+	std::ostream & stream = output.stream();
+
+	stream << "module;\n";
+	stream << "\n";
+	writeApiIncludes(options, stream);
+	stream << "\n";
+	stream << "export module " << options.moduleName << ";\n";
+	stream << "\n";
+	stream << "export {";
+	writeApiDeclarations(options, stream);
+	stream << "}\n";
+	output.close();
+}
+
+// Client of the GNU make jobserver given in MAKEFLAGS, limiting the number of concurrent compile commands.
+// Without a jobserver, the commands are only limited by the worker threads.
+class JobServer {
+public:
+	JobServer() {
+		const char * makeFlags = std::getenv("MAKEFLAGS");
+		const std::string flags = makeFlags ? makeFlags : "";
+		std::string auth;
+		for (const char * option : { "--jobserver-auth=", "--jobserver-fds=" }) {
+			const auto position = flags.rfind(option);
+			if (position != std::string::npos) {
+				const auto value = position + std::strlen(option);
+				auth = flags.substr(value, flags.find(' ', value) - value);
+				break;
+			}
+		}
+		if (auth.empty()) {
+			return;
+		}
+#ifdef _WIN32
+		// named semaphore
+		semaphore = ::OpenSemaphoreA(SEMAPHORE_ALL_ACCESS, FALSE, auth.c_str());
+		available = semaphore != nullptr;
+#else
+		if (auth.compare(0, 5, "fifo:") == 0) {
+			readFd = writeFd = ::open(auth.c_str() + 5, O_RDWR | O_CLOEXEC);
+			ownsFd = readFd >= 0;
+		}
+		else if (std::sscanf(auth.c_str(), "%d,%d", &readFd, &writeFd) != 2) {
+			readFd = writeFd = -1;
+		}
+		// the descriptors aren't inherited if make doesn't consider bin2cpp as a sub-make ('+' prefix)
+		available = readFd >= 0 && ::fcntl(readFd, F_GETFD) != -1 && ::fcntl(writeFd, F_GETFD) != -1;
+#endif
+	}
+
+	~JobServer() {
+#ifdef _WIN32
+		if (semaphore) {
+			::CloseHandle(semaphore);
+		}
+#else
+		if (ownsFd) {
+			::close(readFd);
+		}
+#endif
+	}
+
+	JobServer(const JobServer &) = delete;
+	JobServer & operator=(const JobServer &) = delete;
+
+	// Wait for a job slot: the implicit slot given to bin2cpp by make, or a token read from the jobserver
+	int acquire() {
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			if (!available || implicitSlotFree) {
+				implicitSlotFree = false;
+				return s_implicitSlot;
+			}
+		}
+#ifdef _WIN32
+		::WaitForSingleObject(semaphore, INFINITE);
+		return 0;
+#else
+		unsigned char token;
+		for (;;) {
+			const auto result = ::read(readFd, &token, 1);
+			if (result == 1) {
+				return token;
+			}
+			if (result < 0 && errno != EINTR && errno != EAGAIN) {
+				throw std::runtime_error{ "Failed to read from the make jobserver" };
+			}
+			if (result < 0 && errno == EAGAIN) {
+				// non blocking fifo (shared with make)
+				std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+			}
+		}
+#endif
+	}
+
+	void release(int slot) {
+		if (!available || slot == s_implicitSlot) {
+			std::lock_guard<std::mutex> lock{ mutex };
+			implicitSlotFree = true;
+			return;
+		}
+#ifdef _WIN32
+		::ReleaseSemaphore(semaphore, 1, nullptr);
+#else
+		const unsigned char token = static_cast<unsigned char>(slot);
+		while (::write(writeFd, &token, 1) < 0 && errno == EINTR) {
+		}
+#endif
+	}
+
+private:
+	static const int s_implicitSlot = -1;
+
+	std::mutex mutex;
+	bool available = false;
+	bool implicitSlotFree = true;
+#ifdef _WIN32
+	HANDLE semaphore = nullptr;
+#else
+	int readFd = -1;
+	int writeFd = -1;
+	bool ownsFd = false;
+#endif
+};
+
+// Forwards the generated files to another sink, keeping a copy of the generated sources (for the compile driver)
+class SourceCaptureSink : public OutputSink {
+public:
+	explicit SourceCaptureSink(OutputSink & target) : target(target) {
+	}
+
+	std::unique_ptr<std::ostream> open(const std::string & fileName) override {
+		if (isSource(fileName)) {
+			return std::unique_ptr<std::ostream>{ new std::ostringstream };
+		}
+		return target.open(fileName);
+	}
+
+	void close(const std::string & fileName, std::unique_ptr<std::ostream> stream) override {
+		if (!isSource(fileName)) {
+			target.close(fileName, std::move(stream));
+			return;
+		}
+		std::string source = static_cast<std::ostringstream &>(*stream).str();
+		std::unique_ptr<std::ostream> output = target.open(fileName);
+		output->write(source.data(), source.size());
+		target.close(fileName, std::move(output));
+
+		std::lock_guard<std::mutex> lock{ mutex };
+		sources[fileName] = std::move(source);
+	}
+
+	// generated .h, .ixx and .cpp files by name
+	std::map<std::string, std::string> sources;
+
+private:
+	static bool isSource(const std::string & fileName) {
+		const std::string extension = fileExtension(fileName);
+		return extension == ".h" || extension == ".ixx" || extension == ".cpp";
+	}
+
+	OutputSink & target;
+	std::mutex mutex;
+};
+
+// Compile the generated .cpp files in parallel and archive their objects in the static library options.libraryName.
+// The objects are cached by hash of their source, of the headers and of the compile command.
+// The module interface unit is compiled first, the other units importing it.
+void buildLibrary(const Options & options, const std::map<std::string, std::string> & sources, Generator::Impl & generator, OutputSink & sink, const Progress & progress) {
+	if (options.compileCommand.empty()) {
+		throw std::runtime_error{ "No compile command to build the library " + options.libraryName };
+	}
+	const fs::path buildDir = options.workDir / ".bin2cpp-build";
+	const fs::path objectCacheDir = options.cacheDir.empty() ? buildDir : options.cacheDir;
+	fs::create_directories(buildDir);
+
+	// the headers are included by all the sources
+	unsigned long long headersHash = hashData(options.compileCommand + '\0');
+	std::vector<std::string> units;
+	std::set<std::string> groupSources;
+	for (auto group : options.libraryGroups) {
+		// built as shared libraries
+		groupSources.insert(groupLibraryName(options, group) + ".cpp");
+	}
+	for (const auto & source : sources) {
+		if (groupSources.count(source.first)) {
+			continue;
+		}
+		if (fileExtension(source.first) == ".h") {
+			writeFile(buildDir / source.first, source.second);
+			headersHash = hashData(source.first + '\0' + source.second, headersHash);
+		}
+		else if (fileExtension(source.first) == ".ixx") {
+			// imported by the other units, it's compiled first
+			units.insert(units.begin(), source.first);
+			headersHash = hashData(source.first + '\0' + source.second, headersHash);
+		}
+		else {
+			units.push_back(source.first);
+		}
+	}
+	const size_t interfaceCount = options.moduleName.empty() ? 0 : 1;
+	notify(progress.onMessage, "Compiling " + std::to_string(units.size()) + " file(s)...");
+
+	JobServer jobServer;
+	std::vector<fs::path> objects(units.size());
+	std::atomic<unsigned int> compiledCount{ 0 };
+	std::mutex mutex;
+	std::string error;
+	std::atomic<bool> failed{ false };
+	auto compileUnit = [&](size_t i) {
+		if (failed) {
+			// no other compile is started after a failure
+			return;
+		}
+		try {
+			const std::string & source = sources.at(units[i]);
+			std::ostringstream cacheName;
+			cacheName << std::hex << hashData(source, headersHash) << ".o";
+			const fs::path cachedObject = objectCacheDir / cacheName.str();
+			// the module interface also produces the compiled interface imported by the other units
+			objects[i] = buildDir / (fs::path{ units[i] }.stem().generic_string() + (i < interfaceCount ? "_interface.o" : ".o"));
+
+			if (i >= interfaceCount && fs::is_regular_file(cachedObject)) {
+				writeFile(objects[i], readFile(cachedObject));
+				return;
+			}
+			const fs::path sourceFile = buildDir / units[i];
+			writeFile(sourceFile, source);
+			const std::string commandLine = options.compileCommand + " -c \"" + sourceFile.generic_string() + "\" -o \"" + objects[i].generic_string() + "\"";
+			const int slot = jobServer.acquire();
+			const int status = std::system(commandLine.c_str());
+			jobServer.release(slot);
+			if (status != 0) {
+				throw std::runtime_error{ "Compile command failed: " + commandLine };
+			}
+			writeCacheFile(cachedObject, readFile(objects[i]));
+			++compiledCount;
+		}
+		catch (const std::exception & e) {
+			failed = true;
+			std::lock_guard<std::mutex> lock{ mutex };
+			if (error.empty()) {
+				error = units[i] + ": " + e.what();
+			}
+		}
+	};
+	for (size_t i = 0; i < interfaceCount; ++i) {
+		compileUnit(i);
+	}
+	generator.pool.parallelFor(units.size() - interfaceCount, [&](size_t i, unsigned int) {
+		compileUnit(interfaceCount + i);
+	});
+
+	if (!error.empty()) {
+		throw std::runtime_error{ "Failed to compile " + error };
+	}
+	notify(progress.onMessage, std::to_string(compiledCount) + " file(s) compiled, " + std::to_string(units.size() - compiledCount) + " up to date.");
+
+	// the archivers add the objects to an existing library, it's rebuilt from scratch
+	const fs::path library = buildDir / fs::path{ options.libraryName }.filename();
+	fs::remove(library);
+	// "lib /OUT:" expects the library name without space
+	const bool attachedName = !options.archiverCommand.empty() && options.archiverCommand.back() == ':';
+	std::string commandLine = options.archiverCommand + (attachedName ? "\"" : " \"") + library.generic_string() + "\"";
+	for (auto object : objects) {
+		commandLine += " \"" + object.generic_string() + "\"";
+	}
+	if (std::system(commandLine.c_str()) != 0) {
+		throw std::runtime_error{ "Archive command failed: " + commandLine };
+	}
+
+	OutputFile output{ options.libraryName, sink, progress };
+	const std::string data = readFile(library);
+	output.stream().write(data.data(), data.size());
+	output.close();
+}
+
+} // anonymous namespace
+
+void addInput(Options & options, const std::string & value) {
+	if (fs::is_directory(value) && !options.scanCacheFile.empty()) {
+		auto listings = loadScanCache(options.scanCacheFile);
+		// the time stamps of the last seconds may not reflect all the modifications yet
+		const long long recentTime = static_cast<long long>((fs::file_time_type::clock::now() - std::chrono::seconds{ 2 }).time_since_epoch().count());
+		std::set<std::string> scanned;
+		scanDirectory(value, listings, scanned, recentTime, options.inputFiles);
+
+		// forget the directories removed from the scanned tree
+		const std::string root = fs::path{ value }.generic_string();
+		for (auto it = listings.begin(); it != listings.end();) {
+			const bool inTree = it->first == root || (it->first.compare(0, root.size(), root) == 0 && (root.back() == '/' || it->first[root.size()] == '/'));
+			it = inTree && scanned.count(it->first) == 0 ? listings.erase(it) : std::next(it);
+		}
+		saveScanCache(options.scanCacheFile, listings);
+	}
+	else if (fs::is_directory(value)) {
+		// this syntax requires boost filesystem version >= 1.61
+		for (auto path : fs::recursive_directory_iterator{ value }) {
+			if (fs::is_regular_file(path)) {
+				// use generic_string() to normalize the path on Windows platform
+				options.inputFiles.push_back(path.path().generic_string());
+			}
+		}
+	}
+	else if (options.expandArchives && fs::is_regular_file(value) && !archiveKind(value).empty()) {
+		// the members are only listed here, their data is streamed from the archive by the generator
+		for (auto member : listArchiveMembers(value)) {
+			const std::string path = value + "/" + member.first;
+			member.second.archive = value;
+			// a member stored several times in the archive is replaced by its last version
+			if (options.archiveMembers.count(path) == 0) {
+				options.inputFiles.push_back(path);
+			}
+			options.archiveMembers[path] = member.second;
+		}
+	}
+	else if (fs::is_regular_file(value)) {
+		options.inputFiles.push_back(value);
+	}
+	else {
+		throw std::runtime_error{ "Can't find file or directory named " + value };
+	}
+}
+
+
+DirectorySink::DirectorySink(const fs::path & directory) : directory{ directory } {
+}
+
+std::unique_ptr<std::ostream> DirectorySink::open(const std::string & fileName) {
+	const fs::path path = directory.empty() ? fs::path{ fileName } : directory / fileName;
+	std::unique_ptr<std::ostream> stream{ new std::ofstream{ path, std::ios_base::out | std::ios_base::binary } };
+	if (!*stream) {
+		throw std::runtime_error{ "Failed to create file " + path.generic_string() };
+	}
+	return stream;
+}
+
+void DirectorySink::close(const std::string & fileName, std::unique_ptr<std::ostream> stream) {
+	stream->flush();
+	if (!*stream) {
+		throw std::runtime_error{ "Failed to write file " + fileName };
+	}
+}
+
+std::unique_ptr<std::ostream> MemorySink::open(const std::string &) {
+	return std::unique_ptr<std::ostream>{ new std::ostringstream };
+}
+
+void MemorySink::close(const std::string & fileName, std::unique_ptr<std::ostream> stream) {
+	files[fileName] = static_cast<std::ostringstream &>(*stream).str();
+}
+
+Generator::Generator(unsigned int threadCount) : impl{ new Impl{ threadCount } } {
+}
+
+Generator::~Generator() {
+}
+
+void Generator::generate(const Options & options, OutputSink & outputSink, const Progress & progress) {
+	// the sources are kept to be compiled into the library
+	SourceCaptureSink captureSink{ outputSink };
+	OutputSink & sink = options.libraryName.empty() ? outputSink : captureSink;
+
+	if (progress.counters) {
+		progress.counters->totalBytes = 0;
+		progress.counters->totalFiles = 0;
+		progress.counters->bytesDone = 0;
+		progress.counters->filesDone = 0;
+	}
+	const auto transformedFiles = transformFiles(options, *impl, progress);
+	// the data of each input file is written once (in the pack, a group library or the main bundle)
+	unsigned long long totalBytes = 0;
+	for (const auto & path : options.inputFiles) {
+		const auto transformed = transformedFiles.find(path);
+		const unsigned long long size = transformed != transformedFiles.end() ? transformed->second.size() : inputFileSize(options, path);
+		if (size > s_maxFileSize) {
+			throw std::runtime_error{ "File too large to be embedded (4 GB or more): " + path };
+		}
+		totalBytes += size;
+	}
+	if (progress.counters) {
+		progress.counters->totalBytes = totalBytes;
+		progress.counters->totalFiles = options.inputFiles.size();
+	}
+
+	Options codeOptions = options;
+	if (!options.packFileName.empty()) {
+		// the input files go to the pack file, the generated code only embeds the runtime to read it
+		generatePackFile(options, transformedFiles, *impl, sink, progress);
+		codeOptions.inputFiles.clear();
+		codeOptions.preloadList.clear();
+	}
+	if (!options.libraryGroups.empty()) {
+		// the files of the groups go to the sources of their shared libraries, instead of the main bundle
+		const auto groups = groupFiles(codeOptions);
+		for (auto group : options.libraryGroups) {
+			const auto files = groups.find(group);
+			generateGroupLibrary(options, group, files != groups.end() ? files->second : std::vector<std::string>{}, transformedFiles, *impl, sink, progress);
+		}
+		std::set<std::string> groupedFiles;
+		for (const auto & group : groups) {
+			groupedFiles.insert(group.second.begin(), group.second.end());
+		}
+		const auto grouped = [&](const std::string & path) {
+			return groupedFiles.count(path) != 0;
+		};
+		codeOptions.inputFiles.erase(std::remove_if(codeOptions.inputFiles.begin(), codeOptions.inputFiles.end(), grouped), codeOptions.inputFiles.end());
+		codeOptions.preloadList.erase(std::remove_if(codeOptions.preloadList.begin(), codeOptions.preloadList.end(), grouped), codeOptions.preloadList.end());
+	}
+
+	if (options.shardCount > 1) {
+		// the shards and the index are written first, once all the shard symbols are known
+		generateBodyFile(codeOptions, transformedFiles, *impl, sink, progress);
+		generateHeaderFile(codeOptions, sink, progress);
+	}
+	else {
+		generateHeaderFile(codeOptions, sink, progress);
+		generateBodyFile(codeOptions, transformedFiles, *impl, sink, progress);
+	}
+	if (!options.constexprPatterns.empty()) {
+		const std::string constexprFileName = fs::path{ options.headerFileName }.stem().generic_string() + "_constexpr.h";
+		generateConstexprHeader(options, transformedFiles, *impl, constexprFileName, sink, progress);
+	}
+	if (!options.moduleName.empty()) {
+		const std::string moduleFileName = fs::path{ options.headerFileName }.stem().generic_string() + ".ixx";
+		generateModuleFile(codeOptions, moduleFileName, sink, progress);
+	}
+	if (!options.libraryName.empty()) {
+		buildLibrary(options, captureSink.sources, *impl, outputSink, progress);
+	}
+	impl->archiveStreams.clear();
+}
+
+} // namespace bin2cpp
@@ -0,0 +1,227 @@
+/*
+ *  libbin2cpp: generates C++11 source code which embed several external (binary) files.
+ *
+ *  Usage:
+ *	bin2cpp::Options options;
+ *	options.namespaceName = "myNamespace";
+ *	bin2cpp::addInput(options, "input");
+ *
+ *	bin2cpp::Generator generator;
+ *	bin2cpp::MemorySink sink;
+ *	generator.generate(options, sink);
+ *	// sink.files["bin2cpp.h"], sink.files["bin2cpp.cpp"]
+ *
+ *  License:
+ *  - This is free and unencumbered software released into the public domain.
+ *  - For more information, please refer to http://unlicense.org/
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <ostream>
+#include <filesystem>
+
+namespace bin2cpp {
+
+namespace fs = std::tr2::sys;
+
+// Build-time transform applied to the input files matching a glob pattern
+struct TransformRule {
+	std::string pattern;
+	// "json", "strip" or "cmd:<command line>"
+	std::string transform;
+};
+
+// Tag given to the input files matching a glob pattern
+struct TagRule {
+	std::string pattern;
+	std::string tag;
+};
+
+// Position in the tar stream of a .tar.gz from which its decompression can resume (saved while listing its members)
+struct ArchiveCheckpoint {
+	// position in the decompressed tar stream
+	unsigned long long offset = 0;
+	// position in the .tar.gz file of the next deflate block, in bits
+	unsigned long long inputBitPosition = 0;
+	// last 32 KB of decompressed data, referenced by the next blocks
+	std::string window;
+};
+
+// Member of an archive (.tar, .tar.gz, .tgz or .zip) embedded as an input file
+struct ArchiveMember {
+	// path of the archive file
+	std::string archive;
+	// position of the data in the archive (in the decompressed tar stream for a .tar.gz)
+	unsigned long long offset = 0;
+	// size of the data in the archive, and once decompressed
+	unsigned long long storedSize = 0;
+	unsigned long long size = 0;
+	// the data is compressed with deflate (zip)
+	bool deflated = false;
+	// checkpoints of a .tar.gz, shared by all its members, so a member is decompressed from the closest one
+	std::shared_ptr<const std::vector<ArchiveCheckpoint>> checkpoints;
+};
+
+// Generation options.
+// We don't support Unicode (wide strings) but that's on purpose (given strings will appear in C++ source code)
+struct Options {
+	// list of files to embed
+	std::vector<std::string> inputFiles;
+	// generated file names
+	std::string headerFileName = "bin2cpp.h";
+	std::string cppFileName = "bin2cpp.cpp";
+	// C++ namespace to use (if any)
+	std::string namespaceName;
+	// generate the preloading runtime (startPreload(), waitPreloaded())
+	bool generatePreload = false;
+	// files to be preloaded first by startPreload() (highest priority first)
+	std::vector<std::string> preloadList;
+	// generate the asynchronous content access API
+	bool generateAsyncApi = false;
+	// transforms to apply (in order) to the matching input files
+	std::vector<TransformRule> transforms;
+	// directory where to cache the transform results (if any)
+	fs::path cacheDir;
+	// directory where to write the scratch files of the transform commands
+	fs::path workDir = ".";
+	// name of the C++20 module to generate (if any), saved with the header base name and the .ixx extension
+	std::string moduleName;
+	// store the file names in a front-coded table instead of plain strings
+	bool frontCodedNames = false;
+	// generate the index of the normalized file names
+	bool normalizedIndex = false;
+	// generate the index of the files by extension
+	bool extensionIndex = false;
+	// generate the index of the files by hash of their content
+	bool contentHashIndex = false;
+	// how the data is written: "hex" (array of bytes), "string" (string literal), "embed" (#embed directive)
+	// or "auto" (the fastest to compile representation supported by the compiler, chosen per file)
+	std::string encoding = "hex";
+	// compiler command probed by the "auto" encoding (the portable limits are assumed if empty)
+	std::string compilerCommand;
+	// directory the "embed" paths are relative to, where the generated files are compiled from (absolute paths if empty)
+	fs::path embedDirectory;
+	// glob patterns of the files whose content is also generated as constexpr string views, in "<header base name>_constexpr.h"
+	std::vector<std::string> constexprPatterns;
+	// number of .cpp files the data is split into ("<cpp base name>_<i>.cpp"), written in parallel
+	unsigned int shardCount = 1;
+	// size of the blocks checked by the integrity verification runtime (0 to disable it)
+	unsigned int crcBlockSize = 0;
+	// tags to give to the matching input files, indexed for filesByTag()
+	std::vector<TagRule> tags;
+	// write the input files in a pack file loadable at runtime instead of embedding them (if any)
+	std::string packFileName;
+	// generate the overlay virtual filesystem (Vfs) merging bundles and disk directories
+	bool generateVfs = false;
+	// generate sharedDecode(), sharing the decoded files between the processes through shared memory
+	bool generateSharedCache = false;
+	// tags of the files embedded in shared libraries loaded by loadGroup(), instead of the main bundle:
+	// the files of each group are written in "<header base name>_<group>.cpp", to be built as "[lib]<header base name>_<group>.so/.dll"
+	std::vector<std::string> libraryGroups;
+	// register the bundle in the registry merging the bundles of the module (bin2cpp::findRegisteredFile())
+	bool registerBundle = false;
+	// generate lazyDecode(), decoding the blocks of a content on their first access (userfaultfd on Linux)
+	bool generateLazyDecode = false;
+	// file where addInput() saves the listings of the directories, so only the modified directories are listed again (if any)
+	fs::path scanCacheFile;
+	// embed the members of the archives given to addInput() instead of the archives themselves
+	bool expandArchives = false;
+	// archive members of inputFiles ("<archive path>/<member path>"), read from their archive instead of the disk
+	std::map<std::string, ArchiveMember> archiveMembers;
+	// static library where to compile the generated .cpp files (if any), written along the generated files
+	std::string libraryName;
+	// compiler command building the objects of the library ("-c <source> -o <object>" is appended)
+	std::string compileCommand;
+	// command archiving the objects in the library ("<library> <objects...>" is appended, without space after a ':')
+	std::string archiverCommand = "ar rcs";
+};
+
+// Add an input file, or the files of an input directory (recursively iterated),
+// or the members of an archive if options.expandArchives is set
+void addInput(Options & options, const std::string & path);
+
+// Receives the generated files
+class OutputSink {
+public:
+	virtual ~OutputSink() {
+	}
+
+	// Return the stream where to write the given generated file
+	virtual std::unique_ptr<std::ostream> open(const std::string & fileName) = 0;
+	// Called once the stream returned by open() has been fully written
+	virtual void close(const std::string & fileName, std::unique_ptr<std::ostream> stream) = 0;
+};
+
+// Save the generated files in a directory
+class DirectorySink : public OutputSink {
+public:
+	explicit DirectorySink(const fs::path & directory = fs::path{});
+
+	std::unique_ptr<std::ostream> open(const std::string & fileName) override;
+	void close(const std::string & fileName, std::unique_ptr<std::ostream> stream) override;
+
+private:
+	fs::path directory;
+};
+
+// Keep the generated files in memory
+class MemorySink : public OutputSink {
+public:
+	std::unique_ptr<std::ostream> open(const std::string & fileName) override;
+	void close(const std::string & fileName, std::unique_ptr<std::ostream> stream) override;
+
+	// content of the generated files by name
+	std::map<std::string, std::string> files;
+};
+
+// Amount of input data written, updated by the worker threads without locking,
+// to be polled from another thread (to display the progress, ...)
+struct ProgressCounters {
+	// set once the input files are listed (after the transforms)
+	std::atomic<unsigned long long> totalBytes{ 0 };
+	std::atomic<unsigned long long> totalFiles{ 0 };
+	// the bytes are counted by chunks of 1 MB while the data of a file is written
+	std::atomic<unsigned long long> bytesDone{ 0 };
+	std::atomic<unsigned long long> filesDone{ 0 };
+};
+
+// Progress notifications (all optional)
+struct Progress {
+	// informative message
+	std::function<void(const std::string & message)> onMessage;
+	// a generated file is about to be written
+	std::function<void(const std::string & fileName)> onOutputFile;
+	// an input file is about to be embedded
+	std::function<void(const std::string & fileName)> onInputFile;
+	// reset and updated by generate() if given
+	ProgressCounters * counters = nullptr;
+};
+
+// Generates the C++ source code.
+// A generator keeps a pool of worker threads and the results of the transforms,
+// so it should be reused to run many generations in the same process.
+class Generator {
+public:
+	// threadCount = 0 means one thread per core
+	explicit Generator(unsigned int threadCount = 0);
+	~Generator();
+
+	Generator(const Generator &) = delete;
+	Generator & operator=(const Generator &) = delete;
+
+	void generate(const Options & options, OutputSink & sink, const Progress & progress = Progress{});
+
+	struct Impl;
+
+private:
+	std::unique_ptr<Impl> impl;
+};
+
+} // namespace bin2cpp
@@ -4,9 +4,32 @@
  *
  *  Features:
  *  - can wrap the generated code into a namespace
- *  - can iterate (recursively) over the files of a given folder
+ *  - can iterate (recursively) over the files of a given folder, only listing again the modified folders
+ *  - can embed the members of .tar, .tar.gz and .zip archives without extracting them to the disk
  *  - name of the original input file is also embedded with its data
  *  - provides a C++11 interface compatible with range-based for loops  
+ *  - can preload the embedded files on a background thread, following a priority list
+ *  - can provide an asynchronous (future, callback or C++20 coroutine) content access API
+ *  - can transform (minify, strip, external command) the files before embedding them
+ *  - can generate a C++20 module interface unit for the generated API
+ *  - can copy the content to caller provided buffers, allocators or std::pmr memory resources
+ *  - can find a file by name (binary search), optionally using a front-coded (prefix compressed) name table
+ *  - can find a file by normalized name (case insensitive, '\' or '/' separators)
+ *  - can list the files by extension or by user-defined tag (glob rules)
+ *  - can move groups of (tagged) files to shared libraries loaded on first access
+ *  - can find a file by hash of its content
+ *  - can register the bundles in a registry finding a file in all the bundles of the program (O(1) lookup)
+ *  - can verify the integrity of the embedded data (CRC32C per block, checked lazily)
+ *  - can write the data as arrays, string literals or #embed directives, chosen for the target compiler
+ *  - can embed sparse files (disk images...) without reading their holes
+ *  - can split the data in several .cpp files written in parallel
+ *  - can compile the generated files in parallel into a static library (make jobserver aware, cached objects)
+ *  - displays the progress of long generations (throughput, remaining time)
+ *  - can expose the content of small files to constant expressions (constexpr string views)
+ *  - can write the files in a pack loadable at runtime (memory mapped, O(1) lookups)
+ *  - can overlay embedded files with files on disk through a virtual filesystem
+ *  - can share the content decoded from the files between processes (shared memory)
+ *  - can decode the content of the files lazily, block by block on first access (userfaultfd)
  *
  *  License:
  *  - This is free and unencumbered software released into the public domain.
@@ -19,27 +42,41 @@
  *  - Aurelien Regat-Barrel (https://github.com/aurelienrb/bin2cpp)
  */
 
+#include "bin2cpp.h"
+
 #include <string>
 #include <vector>
 #include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
 #include <iostream>
-#include <sstream>
 #include <fstream>
-#include <filesystem>
-namespace fs = std::tr2::sys;
-
-// Program options.
-// We don't support Unicode (wide strings) but that's on purpose (given strings will appear in C++ source code)
-struct Options {
-	// list of files to embed
-	std::vector<std::string> inputFiles;
-	// outout directory for generated files
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace fs = bin2cpp::fs;
+using bin2cpp::Options;
+using bin2cpp::TagRule;
+using bin2cpp::TransformRule;
+
+// Program options
+struct CommandLine {
+	// generation options
+	Options options;
+	// output directory for generated files
 	fs::path outputDir;
-	// output file names
-	std::string headerFileName;
-	std::string cppFileName;
-	// C++ namespace to use (if any)
-	std::string namespaceName;
+	// don't print the input files nor the progress
+	bool quiet = false;
 };
 
 const std::string s_defaultOutputBase = "bin2cpp";
@@ -51,25 +88,110 @@ void displayUsage() {
 	std::cout << " <input>	: path to an input file or directory to embed in C++ code.\n";
 	std::cout << "			  If it's a directory, its content will be recursively iterated.\n";
 	std::cout << "			  Note: several inputs can be passed on the command line.\n";
+	std::cout << " -scan-cache <file> : file where to save the listings of the following input directories,\n";
+	std::cout << "			  so the next runs only list again the (sub)directories modified since.\n";
+	std::cout << " -archives  : embed the members of the following .tar, .tar.gz (.tgz) and .zip inputs\n";
+	std::cout << "			  (named '<archive>/<member>') instead of the archives themselves.\n";
 	std::cout << " -h		 : this help message.\n";
+	std::cout << " -q		 : quiet mode, neither list the input files nor display the progress.\n";
+	std::cout << "			  Note: on a terminal, the progress (throughput, ETA) is displayed instead of the input files.\n";
 	std::cout << " -d <path>  : directory where to save the generated files.\n";
 	std::cout << " -o <name>  : base name to be used for the generated .h/.cpp files.\n";
 	std::cout << "			  => '-o generated' will produce 'generated.h' and 'generated.cpp' files.\n";
 	std::cout << "			  Default value is '" << s_defaultOutputBase << "'.\n";
 	std::cout << " -ns <name> : name of the namespace to be used in generated code (recommended).\n";
 	std::cout << "			  Default is empty (no namespace).\n";
+	std::cout << " -preload <file> : generate the preloading runtime (startPreload(), ...), <file> listing (one per line)\n";
+	std::cout << "			  the input files to be preloaded first. The other files are preloaded afterwards.\n";
+	std::cout << " -async	 : generate the asynchronous content access API (loadContentAsync(), ...).\n";
+	std::cout << " -transform <glob>=<transform> : transform the matching input files before embedding them.\n";
+	std::cout << "			  <transform> is 'json' (minify), 'strip' (strip blank lines and indentation)\n";
+	std::cout << "			  or 'cmd:<command>' (command reading stdin and writing stdout).\n";
+	std::cout << "			  A glob without '/' is matched against the file name only.\n";
+	std::cout << "			  Note: can be repeated, matching transforms are chained in order.\n";
+	std::cout << " -cache <path> : directory where to cache the transform results.\n";
+	std::cout << " -module <name> : also generate a C++20 module interface unit (.ixx) declaring the generated API.\n";
+	std::cout << "			  => '-module myNamespace.assets' will produce 'export module myNamespace.assets;'.\n";
+	std::cout << "			  Note: the generated .cpp files are then units of the module.\n";
+	std::cout << " -tag <glob>=<tag> : give a tag to the matching input files, see filesByTag().\n";
+	std::cout << "			  A glob without '/' is matched against the file name only.\n";
+	std::cout << "			  Note: can be repeated.\n";
+	std::cout << " -dlgroup <tag> : embed the files with the given tag in a shared library loaded by loadGroup(\"<tag>\")\n";
+	std::cout << "			  instead of the main bundle => '-o generated -dlgroup big' will also produce 'generated_big.cpp',\n";
+	std::cout << "			  to be built as 'libgenerated_big.so' (or 'generated_big.dll').\n";
+	std::cout << "			  Note: can be repeated.\n";
+	std::cout << " -names <mode> : how the file names are stored: 'plain' (one string per file, default)\n";
+	std::cout << "			  or 'frontcoded' (sorted and prefix compressed, decoded on demand by name()).\n";
+	std::cout << " -index <kind> : generate an additional lookup index:\n";
+	std::cout << "			  'normalized' for findFileNormalized() (case insensitive, '\\' or '/' separators),\n";
+	std::cout << "			  'extension' for filesByExtension() or 'hash' for findFileByHash().\n";
+	std::cout << "			  Note: can be repeated.\n";
+	std::cout << " -encoding <mode> : how the data is written: 'hex' (array of bytes, default), 'string' (string literal),\n";
+	std::cout << "			  'embed' (C23/C++26 #embed directive) or 'auto' (chosen per file, see -cxx).\n";
+	std::cout << " -cxx <command> : compiler command probed by '-encoding auto' (the probed source file is appended),\n";
+	std::cout << "			  such as \"g++ -std=c++17 -fsyntax-only\" or \"cl /nologo /Zs\".\n";
+	std::cout << " -embed-dir <path> : write the #embed paths relative to <path> (the directory of the generated files)\n";
+	std::cout << "			  instead of absolute paths.\n";
+	std::cout << " -constexpr <glob> : also generate the content of the matching (small) files as constexpr string views\n";
+	std::cout << "			  => '-o generated' will produce 'generated_constexpr.h' (C++17).\n";
+	std::cout << "			  Note: can be repeated.\n";
+	std::cout << " -shards <n> : split the data of the files in <n> .cpp files written in parallel\n";
+	std::cout << "			  => '-o generated -shards 2' will also produce 'generated_0.cpp' and 'generated_1.cpp'.\n";
+	std::cout << " -lib <name> : compile the generated .cpp files (in parallel) into the static library <name>,\n";
+	std::cout << "			  saved along the generated files. Requires -compile.\n";
+	std::cout << "			  The objects are cached (in the -cache directory if given) by hash of their sources.\n";
+	std::cout << " -compile <command> : compiler command building the objects of -lib\n";
+	std::cout << "			  ('-c <source> -o <object>' is appended), such as \"g++ -O2 -fPIC\".\n";
+	std::cout << "			  Note: the GNU make jobserver given by MAKEFLAGS limits the concurrent compilations.\n";
+	std::cout << " -ar <command> : command archiving the objects of -lib ('<library> <objects...>' is appended).\n";
+	std::cout << "			  Default is 'ar rcs'. A command ending with ':' such as 'lib /nologo /OUT:' is followed by\n";
+	std::cout << "			  the library name without space.\n";
+	std::cout << " -crc <size> : generate the integrity verification runtime (verifyContent(), ...)\n";
+	std::cout << "			  checking the CRC32C of each block of <size> bytes of the files.\n";
+	std::cout << " -pack <name> : write the input files in a pack file loadable at runtime (bin2cpp::Pack)\n";
+	std::cout << "			  instead of embedding them. The generated code then only contains the runtime.\n";
+	std::cout << " -vfs	 : generate the overlay virtual filesystem (Vfs) merging embedded bundles\n";
+	std::cout << "			  and directories on disk with priorities.\n";
+	std::cout << " -shm	 : generate sharedDecode(), which shares the content decoded from a file between\n";
+	std::cout << "			  the processes of the user through shared memory.\n";
+	std::cout << " -register  : register the bundle in the registry merging the bundles of the program\n";
+	std::cout << "			  (bin2cpp::findRegisteredFile()), collected by the linker without dynamic initializer.\n";
+	std::cout << " -lazy	 : generate lazyDecode(), which returns the content decoded from a file as plain memory\n";
+	std::cout << "			  whose blocks are decoded on their first access (userfaultfd, Linux only).\n";
+}
+
+// Read the preload priority list (one input file name per line)
+std::vector<std::string> readPreloadList(const std::string & fileName) {
+	std::ifstream stream{ fileName };
+	if (!stream) {
+		throw std::runtime_error{ "Failed to open preload list " + fileName };
+	}
+
+	std::vector<std::string> names;
+	std::string line;
+	while (std::getline(stream, line)) {
+		// tolerate files edited on Windows
+		if (!line.empty() && line.back() == '\r') {
+			line.pop_back();
+		}
+		if (!line.empty()) {
+			names.push_back(line);
+		}
+	}
+	return names;
 }
 
 // Parse supported program options (-o, -ns, ...)
-void parseNamedArgument(const std::string & argName, const std::string & argValue, Options & options) {
+void parseNamedArgument(const std::string & argName, const std::string & argValue, CommandLine & commandLine) {
 	assert(argName.front() == '-');
 	assert(!argValue.empty());
+	Options & options = commandLine.options;
 
 	if (argName == "-d") {
 		if (!fs::is_directory(argValue)) {
 			throw std::runtime_error{ "Invalid output directory: " + argValue };
 		}
-		options.outputDir = argValue;
+		commandLine.outputDir = argValue;
 	}
 	else if (argName == "-o") {
 		options.headerFileName = argValue + ".h";
@@ -78,33 +200,144 @@ void parseNamedArgument(const std::string & argName, const std::string & argValu
 	else if (argName == "-ns") {
 		options.namespaceName = argValue;
 	}
+	else if (argName == "-preload") {
+		options.generatePreload = true;
+		options.preloadList = readPreloadList(argValue);
+	}
+	else if (argName == "-transform") {
+		const auto separator = argValue.find('=');
+		if (separator == std::string::npos || separator == 0 || separator == argValue.size() - 1) {
+			throw std::runtime_error{ "Invalid transform (expected <glob>=<transform>): " + argValue };
+		}
+		TransformRule rule{ argValue.substr(0, separator), argValue.substr(separator + 1) };
+		if (rule.transform != "json" && rule.transform != "strip" && rule.transform.compare(0, 4, "cmd:") != 0) {
+			throw std::runtime_error{ "Unknown transform: " + rule.transform };
+		}
+		options.transforms.push_back(rule);
+	}
+	else if (argName == "-tag") {
+		const auto separator = argValue.find('=');
+		if (separator == std::string::npos || separator == 0 || separator == argValue.size() - 1) {
+			throw std::runtime_error{ "Invalid tag (expected <glob>=<tag>): " + argValue };
+		}
+		options.tags.push_back(TagRule{ argValue.substr(0, separator), argValue.substr(separator + 1) });
+	}
+	else if (argName == "-dlgroup") {
+		options.libraryGroups.push_back(argValue);
+	}
+	else if (argName == "-names") {
+		if (argValue != "plain" && argValue != "frontcoded") {
+			throw std::runtime_error{ "Invalid name storage mode: " + argValue };
+		}
+		options.frontCodedNames = argValue == "frontcoded";
+	}
+	else if (argName == "-index") {
+		if (argValue == "normalized") {
+			options.normalizedIndex = true;
+		}
+		else if (argValue == "extension") {
+			options.extensionIndex = true;
+		}
+		else if (argValue == "hash") {
+			options.contentHashIndex = true;
+		}
+		else {
+			throw std::runtime_error{ "Invalid index kind: " + argValue };
+		}
+	}
+	else if (argName == "-encoding") {
+		if (argValue != "hex" && argValue != "string" && argValue != "embed" && argValue != "auto") {
+			throw std::runtime_error{ "Invalid encoding: " + argValue };
+		}
+		options.encoding = argValue;
+	}
+	else if (argName == "-embed-dir") {
+		options.embedDirectory = argValue;
+	}
+	else if (argName == "-cxx") {
+		options.compilerCommand = argValue;
+	}
+	else if (argName == "-constexpr") {
+		options.constexprPatterns.push_back(argValue);
+	}
+	else if (argName == "-shards") {
+		char * end = nullptr;
+		const unsigned long shardCount = std::strtoul(argValue.c_str(), &end, 10);
+		if (*end != '\0' || shardCount == 0 || shardCount > 4096) {
+			throw std::runtime_error{ "Invalid shard count: " + argValue };
+		}
+		options.shardCount = static_cast<unsigned int>(shardCount);
+	}
+	else if (argName == "-crc") {
+		char * end = nullptr;
+		const unsigned long blockSize = std::strtoul(argValue.c_str(), &end, 10);
+		if (*end != '\0' || blockSize == 0 || blockSize > 0x7FFFFFFF) {
+			throw std::runtime_error{ "Invalid CRC block size: " + argValue };
+		}
+		options.crcBlockSize = static_cast<unsigned int>(blockSize);
+	}
+	else if (argName == "-lib") {
+		options.libraryName = argValue;
+	}
+	else if (argName == "-compile") {
+		options.compileCommand = argValue;
+	}
+	else if (argName == "-ar") {
+		options.archiverCommand = argValue;
+	}
+	else if (argName == "-pack") {
+		options.packFileName = argValue;
+	}
+	else if (argName == "-module") {
+		options.moduleName = argValue;
+	}
+	else if (argName == "-scan-cache") {
+		options.scanCacheFile = argValue;
+	}
+	else if (argName == "-cache") {
+		if (!fs::is_directory(argValue)) {
+			throw std::runtime_error{ "Invalid cache directory: " + argValue };
+		}
+		options.cacheDir = argValue;
+	}
 	else {
 		throw std::runtime_error{ "Invalid option name: " + argName };
 	}
 }
 
-// Parse one given input value (test if it's a file name or a directory to iterate for the files it contains)
-void parsePositionalArgument(const std::string & value, Options & options) {
-	if (fs::is_directory(value)) {
-		// this syntax requires boost filesystem version >= 1.61
-		for (auto path : fs::recursive_directory_iterator{ value }) {
-			if (fs::is_regular_file(path)) {
-				// use generic_string() to normalize the path on Windows platform
-				options.inputFiles.push_back(path.path().generic_string());
-			}
-		}
+// Parse supported program flags (options without value such as -async)
+bool parseFlagArgument(const std::string & argName, Options & options) {
+	if (argName == "-async") {
+		options.generateAsyncApi = true;
+		return true;
 	}
-	else if (fs::is_regular_file(value)) {
-		options.inputFiles.push_back(value);
+	if (argName == "-vfs") {
+		options.generateVfs = true;
+		return true;
 	}
-	else {
-		throw std::runtime_error{ "Can't find file or directory named " + value };
+	if (argName == "-shm") {
+		options.generateSharedCache = true;
+		return true;
 	}
+	if (argName == "-register") {
+		options.registerBundle = true;
+		return true;
+	}
+	if (argName == "-lazy") {
+		options.generateLazyDecode = true;
+		return true;
+	}
+	if (argName == "-archives") {
+		options.expandArchives = true;
+		return true;
+	}
+	return false;
 }
 
 // Parse the given command line
-Options parseCommandLine(int argc, char ** argv) {
-	Options options;
+CommandLine parseCommandLine(int argc, char ** argv) {
+	CommandLine commandLine;
+	Options & options = commandLine.options;
 
 	if (argc == 1) {
 		displayUsage();
@@ -119,169 +352,175 @@ Options parseCommandLine(int argc, char ** argv) {
 				displayUsage();
 				std::exit(0);
 			}
+			else if (arg == "-q") {
+				commandLine.quiet = true;
+			}
+			else if (parseFlagArgument(arg, options)) {
+				continue;
+			}
 			else if (i == argc - 1) {
 				throw std::runtime_error{ "Missing value for option " + arg };
 			}
 			else {
-				parseNamedArgument(arg, argv[i + 1], options);
+				parseNamedArgument(arg, argv[i + 1], commandLine);
 				i += 1;
 			}
 		}
 		else {
-			parsePositionalArgument(arg, options);
+			bin2cpp::addInput(options, arg);
 		}
 	}
 
-	if (options.cppFileName.empty()) {
-		options.headerFileName = s_defaultOutputBase + ".h";
-		options.cppFileName = s_defaultOutputBase + ".cpp";
+	// scratch files of the transform commands go along the generated files
+	if (!commandLine.outputDir.empty()) {
+		options.workDir = commandLine.outputDir;
 	}
 
-	return options;
+	return commandLine;
 }
 
-void convertFileDataToCppSource(const std::string & fileName, const std::string & fileId, std::ostream & stream) {
-	assert(fs::is_regular_file(fileName));
-
-	std::ifstream inputFile{ fileName, std::ios_base::in | std::ios_base::binary };
-	if (!inputFile) {
-		throw std::runtime_error{std::string("Failed to open file ") + fileName};
+// "12.3 MB"
+std::string formatSize(double size) {
+	static const char * s_units[] = { "B", "KB", "MB", "GB", "TB" };
+	size_t unit = 0;
+	while (size >= 1024 && unit + 1 < sizeof(s_units) / sizeof(s_units[0])) {
+		size /= 1024;
+		unit += 1;
 	}
+	std::ostringstream stream;
+	stream << std::fixed << std::setprecision(unit == 0 ? 0 : 1) << size << " " << s_units[unit];
+	return stream.str();
+}
 
-	// save formatting flags of the given stream
-	std::ios::fmtflags flags(stream.flags());
-	
-	const auto fileLen = static_cast<unsigned int>(fs::file_size(fileName));
-	stream << "\tconst char * " << fileId << "_name = \"" << fileName << "\";\n";
-	stream << "\tconst unsigned int " << fileId << "_data_size = " << fileLen << ";\n";
-	stream << "\tconst unsigned char " << fileId << "_data[" << fileId << "_data_size] = {";
-
-	size_t char_count{ 0 };
-	char c;
-	while (inputFile.get(c)) {
-		if (char_count % 20 == 0) {
-			stream << "\n\t\t";
-		}
-		char_count += 1;
-
-		stream << "0x" << std::hex << (static_cast<int>(c) & 0xFF) << ",";
+// "1:05" or "2:01:05"
+std::string formatDuration(double seconds) {
+	const auto total = static_cast<unsigned long long>(seconds + 0.5);
+	std::ostringstream stream;
+	if (total >= 3600) {
+		stream << total / 3600 << ":" << std::setw(2) << std::setfill('0') << total / 60 % 60;
 	}
-	assert(char_count == fileLen);
-
-	stream << "\n\t};\n";
-
-	// restore save formatting flags
-	stream.flags(flags);
+	else {
+		stream << total / 60;
+	}
+	stream << ":" << std::setw(2) << std::setfill('0') << total % 60;
+	return stream.str();
 }
 
-void generateHeaderFile(const Options & options) {
-	static const char * s_headerContent = R"raw(
-	struct FileInfo {
-		const char * fileName;
-		const char * fileData;
-		const unsigned int fileDataSize;
+bool isTerminal(FILE * file) {
+#ifdef _WIN32
+	return _isatty(_fileno(file)) != 0;
+#else
+	return isatty(fileno(file)) != 0;
+#endif
+}
 
-		std::string name() const {
-			return fileName;
-		}
+// Status line redrawn in place on the terminal while the data is written, from the counters
+// updated by the workers. It's redrawn 5 times per second at most, whatever the number of files.
+class ProgressDisplay {
+public:
+	explicit ProgressDisplay(const bin2cpp::ProgressCounters & counters) :
+		counters(counters), thread{ [this] { run(); } } {
+	}
 
-		std::string content() const {
-			return std::string{ fileData, fileDataSize };
-		}
-	};
+	~ProgressDisplay() {
+		stop();
+	}
 
-	extern const unsigned int fileInfoListSize;
-	extern const FileInfo fileInfoList[];
+	// print a line above the status line
+	void print(const std::string & line) {
+		std::lock_guard<std::mutex> lock{ mutex };
+		std::cout << "\r" << std::string(statusWidth, ' ') << "\r" << line << "\n";
+		statusWidth = 0;
+		draw();
+	}
 
-	struct FileInfoRange {
-		const FileInfo * begin() const {
-			return &fileInfoList[0];
-		}
-		const FileInfo * end() const {
-			return begin() + size();
-		}
-		const size_t size() const {
-			return fileInfoListSize;
-		}
-	};
-
-	inline FileInfoRange fileList() {
-		return FileInfoRange{};
-	}
-)raw";
-
-	const fs::path fileName = options.outputDir.empty() ?
-		options.headerFileName :
-		options.outputDir / options.headerFileName;
-	std::cout << "Generating " << fileName.generic_string() << "...\n";
-	std::ofstream stream{ fileName };
-	if (stream) {
-		stream << "#pragma once\n";
-		stream << "\n";
-		stream << "#include <string>\n";
-
-		if (!options.namespaceName.empty()) {
-			stream << "\n";
-			stream << "namespace " << options.namespaceName << " {";
+	// draw the final state and end the status line
+	void stop() {
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			if (stopped) {
+				return;
+			}
+			stopped = true;
 		}
-		stream << s_headerContent;
-		if (!options.namespaceName.empty()) {
-			stream << "}\n";
+		wakeUp.notify_one();
+		thread.join();
+		if (statusWidth > 0) {
+			draw();
+			std::cout << "\n";
 		}
 	}
-	else {
-		throw std::runtime_error{ "Failed to create header file!" };
-	}
-}
 
-void generateBodyFile(const Options & options) {
-	const fs::path fileName = options.outputDir.empty() ?
-		options.cppFileName :
-		options.outputDir / options.cppFileName;
-
-	std::cout << "Generating " << fileName.generic_string() << "...\n";
-	std::ofstream stream{ fileName };
-	if (stream) {
-		stream << "#include \"" << options.headerFileName << "\"\n";
-		stream << "\n";
-
-		stream << "namespace /* anonymous */ {\n";
-
-		// process the given files
-		std::vector<std::string> fileIds;
-		for (auto path : options.inputFiles) {
-			// increment the file id
-			const std::string fileId = "file" + std::to_string(fileIds.size());
-			// read the file
-			std::cout << "  " << path << "\n";
-			convertFileDataToCppSource(path, fileId, stream);
-			fileIds.emplace_back(fileId);
+private:
+	void run() {
+		std::unique_lock<std::mutex> lock{ mutex };
+		while (!wakeUp.wait_for(lock, std::chrono::milliseconds(200), [this] { return stopped; })) {
+			draw();
 		}
+	}
 
-		stream << "}\n";
-		stream << "\n";
+	// "45% 1.2 GB / 2.7 GB, 310.5 MB/s, 120 / 300 files, ETA 0:05"
+	void draw() {
+		const unsigned long long totalFiles = counters.totalFiles.load(std::memory_order_relaxed);
+		if (totalFiles == 0) {
+			// the inputs aren't listed yet (transforms...)
+			return;
+		}
+		const auto now = std::chrono::steady_clock::now();
+		if (!started) {
+			started = true;
+			start = now;
+		}
+		const unsigned long long totalBytes = counters.totalBytes.load(std::memory_order_relaxed);
+		const unsigned long long bytesDone = counters.bytesDone.load(std::memory_order_relaxed);
+		const unsigned long long filesDone = counters.filesDone.load(std::memory_order_relaxed);
+		if (!finished && filesDone == totalFiles) {
+			// the throughput is only measured while the data is written, not the index written afterwards
+			finished = true;
+			end = now;
+		}
+		const double elapsed = std::chrono::duration<double>((finished ? end : now) - start).count();
 
-		if (!options.namespaceName.empty()) {
-			stream << "namespace " << options.namespaceName << " {\n";
+		std::ostringstream status;
+		if (totalBytes > 0) {
+			status << std::setw(3) << bytesDone * 100 / totalBytes << "% ";
 		}
-		stream << "\tconst unsigned int fileInfoListSize = " << fileIds.size() << ";\n";
-		stream << "\tconst FileInfo fileInfoList[fileInfoListSize] = {\n";
-		for (auto id : fileIds) {
-			stream << "\t\t{ " << id << "_name, reinterpret_cast<const char*>(" << id << "_data), " << id << "_data_size },\n";
+		status << formatSize(static_cast<double>(bytesDone)) << " / " << formatSize(static_cast<double>(totalBytes));
+		if (elapsed > 0.5) {
+			const double rate = bytesDone / elapsed;
+			status << ", " << formatSize(rate) << "/s";
+			if (rate > 0 && bytesDone < totalBytes) {
+				status << ", ETA " << formatDuration((totalBytes - bytesDone) / rate);
+			}
 		}
-		stream << "\t};\n";
-		if (!options.namespaceName.empty()) {
-			stream << "}\n";
+		status << ", " << filesDone << " / " << totalFiles << " files";
+
+		// pad with spaces to erase the end of a longer previous status
+		const std::string line = status.str();
+		std::cout << "\r" << line;
+		if (line.size() < statusWidth) {
+			std::cout << std::string(statusWidth - line.size(), ' ');
 		}
+		std::cout << std::flush;
+		statusWidth = line.size();
 	}
-	else {
-		throw std::runtime_error{ "Failed to create cpp file!" };
-	}
-}
+
+	const bin2cpp::ProgressCounters & counters;
+	std::mutex mutex;
+	std::condition_variable wakeUp;
+	bool stopped = false;
+	bool started = false;
+	bool finished = false;
+	std::chrono::steady_clock::time_point start;
+	std::chrono::steady_clock::time_point end;
+	size_t statusWidth = 0;
+	std::thread thread;
+};
 
 int main(int argc, char ** argv) {
 	try {
-		const auto options = parseCommandLine(argc, argv);
+		const auto commandLine = parseCommandLine(argc, argv);
+		const auto & options = commandLine.options;
 		if (options.inputFiles.empty()) {
 			std::cerr << "Warning: no input file to process, will generate empty C++ output!\n";
 		}
@@ -289,8 +528,39 @@ int main(int argc, char ** argv) {
 			std::cout << "Ready to process " << options.inputFiles.size() << " file(s).\n";
 		}
 
-		generateHeaderFile(options);
-		generateBodyFile(options);
+		// on a terminal the progress is displayed instead of the (many) input file names
+		bin2cpp::ProgressCounters counters;
+		std::unique_ptr<ProgressDisplay> display;
+		bin2cpp::Progress progress;
+		if (!commandLine.quiet && isTerminal(stdout)) {
+			display.reset(new ProgressDisplay{ counters });
+			progress.counters = &counters;
+		}
+		const auto print = [&](const std::string & line) {
+			if (display) {
+				display->print(line);
+			}
+			else {
+				std::cout << line << "\n";
+			}
+		};
+		progress.onMessage = print;
+		progress.onOutputFile = [&](const std::string & fileName) {
+			const fs::path path = commandLine.outputDir.empty() ? fs::path{ fileName } : commandLine.outputDir / fileName;
+			print("Generating " + path.generic_string() + "...");
+		};
+		if (!commandLine.quiet && !display) {
+			progress.onInputFile = [](const std::string & fileName) {
+				std::cout << "  " << fileName << "\n";
+			};
+		}
+
+		bin2cpp::Generator generator;
+		bin2cpp::DirectorySink sink{ commandLine.outputDir };
+		generator.generate(options, sink, progress);
+		if (display) {
+			display->stop();
+		}
 	}
 	catch (const std::exception & e) {
 		std::cerr << "Error: " << e.what() << std::endl;
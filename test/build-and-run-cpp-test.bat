@@ -15,9 +15,34 @@ mkdir output || goto:test_failed
 
 REM see test.cpp for details of what is expected
 copy golden_master.bin input\  || goto:test_failed
-%BIN2CPP% -ns myNamespace -o generated -d output input || goto:test_failed
+echo input/golden_master.bin> preload.txt
+%BIN2CPP% -ns myNamespace -o generated -d output -preload preload.txt -async -index normalized -index extension -index hash -crc 64 -constexpr *.bin -tag *.bin=binary -tag **/input/*.bin=input -vfs -shm -lazy -register input || goto:test_failed
 if not exist output\generated.h goto:test_failed
 if not exist output\generated.cpp goto:test_failed
+mkdir other-input || goto:test_failed
+copy golden_master.bin other-input\other.bin || goto:test_failed
+%BIN2CPP% -ns otherNamespace -o other -d output -names frontcoded -register other-input || goto:test_failed
+%BIN2CPP% -ns archiveNamespace -o archives -d output -archives archive.zip || goto:test_failed
+%BIN2CPP% -ns packNamespace -o pack -d output -pack archive.pak input -archives archive.tar.gz archive.zip || goto:test_failed
+if not exist output\archive.pak goto:test_failed
+REM only the library of the "big" group is built, see test.cpp
+%BIN2CPP% -ns groupNamespace -o grouped -d output -tag **/input/*=big -tag **/other-input/*=missing -dlgroup big -dlgroup missing input other-input || goto:test_failed
+if not exist output\grouped_big.cpp goto:test_failed
+REM the shards are compiled in a static library, the second time from the cached objects
+%BIN2CPP% -ns shardNamespace -o sharded -d output -shards 2 -lib sharded.lib -compile "cl /nologo /EHsc /W4" -ar "lib /nologo /OUT:" input other-input || goto:test_failed
+if not exist output\sharded.lib goto:test_failed
+%BIN2CPP% -ns shardNamespace -o sharded -d output -shards 2 -lib sharded.lib -compile "cl /nologo /EHsc /W4" -ar "lib /nologo /OUT:" input other-input > lib.txt || goto:test_failed
+findstr /c:"0 file(s) compiled, 3 up to date." lib.txt > nul || goto:test_failed
+del lib.txt
+REM the transforms are run once, the second time the results are read from the cache
+mkdir transform-cache || goto:test_failed
+%BIN2CPP% -ns transformNamespace -o transformed -d output -cache transform-cache -transform *.json=json -transform *.glsl=strip -transform *.txt=cmd:sort transform-input || goto:test_failed
+%BIN2CPP% -ns transformNamespace -o transformed -d output -cache transform-cache -transform *.json=json -transform *.glsl=strip -transform *.txt=cmd:sort transform-input > transform.txt || goto:test_failed
+findstr /c:"0 file(s) transformed, 3 from the cache." transform.txt > nul || goto:test_failed
+del transform.txt
+REM see module_test.cpp, the bundle is imported as a module
+%BIN2CPP% -ns moduleNamespace -o assets -d output -module moduleNamespace.assets input || goto:test_failed
+if not exist output\assets.ixx goto:test_failed
 
 :build_src
 echo.
@@ -25,22 +50,32 @@ echo Building test.cpp...
 set BUILDDIR=%~dp0build-dir
 mkdir %BUILDDIR% || exit /b 1
 pushd %BUILDDIR%
-cl /nologo /DEBUG /EHsc /W4 %~dp0\test.cpp %~dp0\output\generated.cpp -I%~dp0\output || exit /b 1
+cl /nologo /DEBUG /EHsc /W4 %~dp0\test.cpp %~dp0\output\generated.cpp %~dp0\output\other.cpp %~dp0\output\archives.cpp %~dp0\output\pack.cpp %~dp0\output\grouped.cpp %~dp0\output\sharded.lib %~dp0\output\transformed.cpp -I%~dp0\output || exit /b 1
+cl /nologo /DEBUG /EHsc /W4 /LD %~dp0\output\grouped_big.cpp -I%~dp0\output /Fe%~dp0\output\grouped_big.dll || exit /b 1
 cl /nologo /DEBUG /EHsc /W4 %~dp0\example.cpp %~dp0\output\generated.cpp -I%~dp0\output || exit /b 1
+REM the interface unit is compiled first, the other units import it
+cl /nologo /DEBUG /EHsc /W4 /std:c++20 /c %~dp0\output\assets.ixx /Foassets_interface.obj || exit /b 1
+cl /nologo /DEBUG /EHsc /W4 /std:c++20 %~dp0\module_test.cpp %~dp0\output\assets.cpp assets_interface.obj || exit /b 1
 popd
 
 :run_test
 if not exist %BUILDDIR%\test.exe exit /b 1
 echo.
 %BUILDDIR%\test.exe || exit /b 1
+%BUILDDIR%\module_test.exe || exit /b 1
 
 :clean
 del /q %BUILDDIR%\*
 rd /q %BUILDDIR%
 del /q input\*
 rd /q input
+del /q other-input\*
+rd /q other-input
+rd /s /q output\.bin2cpp-build
 del /q output\*
 rd /q output
+del /q preload.txt
+rd /s /q transform-cache
 
 echo Success!
 exit /b 0
@@ -0,0 +1,20 @@
+#include <cassert>
+
+// generated with -module moduleNamespace.assets: the API comes from the module, not from the header
+import moduleNamespace.assets;
+
+#define ASSERT_EQ(stm, value) assert(stm == value)
+
+int main() {
+	ASSERT_EQ(moduleNamespace::fileList().size(), 1);
+
+	for (auto & file : moduleNamespace::fileList()) {
+		ASSERT_EQ(file.name().compare("input/golden_master.bin"), 0);
+		ASSERT_EQ(file.fileDataSize, 256);
+		ASSERT_EQ(static_cast<unsigned char>(file.fileData[255]), 255);
+	}
+
+	ASSERT_EQ(moduleNamespace::findFile("input/golden_master.bin"), &moduleNamespace::fileInfoList[0]);
+	ASSERT_EQ(moduleNamespace::findFile("input/golden_master"), nullptr);
+	ASSERT_EQ(moduleNamespace::sortedFileList().size(), 1);
+}
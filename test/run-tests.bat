@@ -30,6 +30,13 @@ REM test with invalid input file
 %BIN2CPP% missing_file && goto:command_line_check_failed
 echo =======
 
+REM test with invalid transform
+%BIN2CPP% -transform json golden_master.bin && goto:command_line_check_failed
+echo =======
+
+%BIN2CPP% -transform *.bin=unknown golden_master.bin && goto:command_line_check_failed
+echo =======
+
 REM process file with default values
 %BIN2CPP% golden_master.bin || goto:command_line_check_failed
 if not exist bin2cpp.h goto:command_line_check_failed
@@ -37,6 +44,108 @@ if not exist bin2cpp.cpp goto:command_line_check_failed
 del bin2cpp.h bin2cpp.cpp
 echo =======
 
+REM test with invalid name storage mode
+%BIN2CPP% -names compressed golden_master.bin && goto:command_line_check_failed
+echo =======
+
+REM test with invalid index kind
+%BIN2CPP% -index unknown golden_master.bin && goto:command_line_check_failed
+echo =======
+
+REM test with invalid tag
+%BIN2CPP% -tag preload golden_master.bin && goto:command_line_check_failed
+echo =======
+
+REM test with invalid CRC block size
+%BIN2CPP% -crc 0 golden_master.bin && goto:command_line_check_failed
+echo =======
+
+REM test with invalid encoding
+%BIN2CPP% -encoding base64 golden_master.bin && goto:command_line_check_failed
+echo =======
+
+REM process file with the encoding chosen for the compiler
+%BIN2CPP% -encoding auto -cxx "cl /nologo /Zs" golden_master.bin || goto:command_line_check_failed
+if not exist bin2cpp.cpp goto:command_line_check_failed
+del bin2cpp.h bin2cpp.cpp
+echo =======
+
+REM write the #embed paths relative to the output directory
+mkdir embed-output || goto:command_line_check_failed
+%BIN2CPP% -encoding embed -d embed-output -embed-dir embed-output golden_master.bin || goto:command_line_check_failed
+findstr /c:"#embed \"../golden_master.bin\"" embed-output\bin2cpp.cpp > nul || goto:command_line_check_failed
+del embed-output\bin2cpp.h embed-output\bin2cpp.cpp
+rd embed-output
+echo =======
+
+REM generate a C++20 module interface unit
+%BIN2CPP% -ns myNamespace -module myNamespace.assets golden_master.bin || goto:command_line_check_failed
+if not exist bin2cpp.ixx goto:command_line_check_failed
+del bin2cpp.h bin2cpp.cpp bin2cpp.ixx
+echo =======
+
+REM split the data in shards
+%BIN2CPP% -ns myNamespace -shards 2 golden_master.bin || goto:command_line_check_failed
+if not exist bin2cpp_0.cpp goto:command_line_check_failed
+if not exist bin2cpp_1.cpp goto:command_line_check_failed
+del bin2cpp.h bin2cpp.cpp bin2cpp_0.cpp bin2cpp_1.cpp
+echo =======
+
+REM compile the shards in a static library
+%BIN2CPP% -ns myNamespace -shards 2 -lib bin2cpp.lib -compile "cl /nologo /EHsc" -ar "lib /nologo /OUT:" golden_master.bin || goto:command_line_check_failed
+if not exist bin2cpp.lib goto:command_line_check_failed
+del bin2cpp.h bin2cpp.cpp bin2cpp_0.cpp bin2cpp_1.cpp bin2cpp.lib
+rd /s /q .bin2cpp-build
+echo =======
+
+REM test with invalid shard count
+%BIN2CPP% -shards 0 golden_master.bin && goto:command_line_check_failed
+echo =======
+
+REM scan the input directory twice with the saved listings
+mkdir scan-input || goto:command_line_check_failed
+copy golden_master.bin scan-input\ || goto:command_line_check_failed
+%BIN2CPP% -scan-cache scan.cache scan-input || goto:command_line_check_failed
+if not exist scan.cache goto:command_line_check_failed
+%BIN2CPP% -scan-cache scan.cache scan-input || goto:command_line_check_failed
+findstr /c:"scan-input/golden_master.bin" bin2cpp.cpp > nul || goto:command_line_check_failed
+del bin2cpp.h bin2cpp.cpp scan.cache scan-input\golden_master.bin
+rd scan-input
+echo =======
+
+REM quiet mode doesn't list the input files
+%BIN2CPP% -q golden_master.bin > quiet.txt || goto:command_line_check_failed
+findstr /c:"golden_master.bin" quiet.txt > nul && goto:command_line_check_failed
+del bin2cpp.h bin2cpp.cpp quiet.txt
+echo =======
+
+REM embed a sparse file (the holes are only made if fsutil is allowed to)
+fsutil file createnew sparse.bin 1048576 > nul || goto:command_line_check_failed
+fsutil sparse setflag sparse.bin > nul && fsutil sparse setrange sparse.bin 0 1048576 > nul
+%BIN2CPP% sparse.bin || goto:command_line_check_failed
+findstr /c:"_data_size = 1048576;" bin2cpp.cpp > nul || goto:command_line_check_failed
+del bin2cpp.h bin2cpp.cpp sparse.bin
+echo =======
+
+REM embed the members of an archive
+tar -cf golden_master.tar golden_master.bin || goto:command_line_check_failed
+%BIN2CPP% -archives golden_master.tar || goto:command_line_check_failed
+findstr /c:"golden_master.tar/golden_master.bin" bin2cpp.cpp > nul || goto:command_line_check_failed
+del bin2cpp.h bin2cpp.cpp golden_master.tar
+echo =======
+
+REM move a group of files to a shared library source
+%BIN2CPP% -ns myNamespace -tag *.bin=binary -dlgroup binary golden_master.bin || goto:command_line_check_failed
+if not exist bin2cpp_binary.cpp goto:command_line_check_failed
+del bin2cpp.h bin2cpp.cpp bin2cpp_binary.cpp
+echo =======
+
+REM write the input file in a runtime loadable pack
+%BIN2CPP% -ns myNamespace -pack golden_master.pak golden_master.bin || goto:command_line_check_failed
+if not exist golden_master.pak goto:command_line_check_failed
+del bin2cpp.h bin2cpp.cpp golden_master.pak
+echo =======
+
 :build_and_run_test_cpp
 call build-and-run-cpp-test.bat || goto:test_failed
 
@@ -1,5 +1,33 @@
 #include "generated.h"
+#include "other.h"
+#include "archives.h"
+#include "pack.h"
+#include "grouped.h"
+#include "sharded.h"
+#include "transformed.h"
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <stdexcept>
+#include <vector>
+#ifndef _WIN32
+#include <cstdlib>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+// generated with -constexpr *.bin
+#include "generated_constexpr.h"
+
+static_assert(myNamespace::constexprFiles::input_golden_master_bin.size() == 256, "constexpr file size");
+static_assert(myNamespace::constexprFiles::input_golden_master_bin[0] == '\x00', "constexpr file content");
+static_assert(myNamespace::constexprFiles::input_golden_master_bin[255] == '\xff', "constexpr file content");
+#endif
 
 #define ASSERT_EQ(stm, value) assert(stm == value)
 
@@ -17,4 +45,406 @@ int main() {
 			ASSERT_EQ(c, i);
 		}
 	}
+
+	// check the content materialization without the default allocation
+	for (auto & file : myNamespace::fileList()) {
+		char buffer[300];
+		ASSERT_EQ(file.copyContent(buffer, sizeof(buffer)), 256);
+		ASSERT_EQ(std::string(buffer, 256), file.content());
+		ASSERT_EQ(file.copyContent(buffer, 10, 250), 6);
+		ASSERT_EQ(static_cast<unsigned char>(buffer[5]), 255);
+		ASSERT_EQ(file.copyContent(buffer, 10, 256), 0);
+		ASSERT_EQ(file.content(std::allocator<char>()), file.content());
+#ifdef __cpp_lib_memory_resource
+		// the whole content comes from the arena, the upstream resource fails on any allocation
+		char arena[512];
+		std::pmr::monotonic_buffer_resource resource{ arena, sizeof(arena), std::pmr::null_memory_resource() };
+		const std::pmr::string content = file.content(&resource);
+		ASSERT_EQ(std::string(content.data(), content.size()), file.content());
+#endif
+	}
+
+	// check lookup by name
+	ASSERT_EQ(myNamespace::findFile("input/golden_master.bin"), &myNamespace::fileInfoList[0]);
+	ASSERT_EQ(myNamespace::findFile("input/golden_master"), nullptr);
+	ASSERT_EQ(myNamespace::findFile(""), nullptr);
+	ASSERT_EQ(myNamespace::sortedFileList().size(), 1);
+	for (auto & file : myNamespace::sortedFileList()) {
+		ASSERT_EQ(&file, &myNamespace::fileInfoList[0]);
+	}
+
+	// check the front-coded names of the second bundle (generated with -names frontcoded), on copies of the entries too
+	ASSERT_EQ(otherNamespace::fileList().size(), 1);
+	for (auto file : otherNamespace::fileList()) {
+		ASSERT_EQ(file.name(), "other-input/other.bin");
+	}
+	const otherNamespace::FileInfo copied = otherNamespace::fileInfoList[0];
+	ASSERT_EQ(copied.name(), "other-input/other.bin");
+	// a FileInfo built by the caller isn't taken for the entry of its fileIndex
+	const otherNamespace::FileInfo builtOther{ nullptr, "abcd", 4, 0 };
+	ASSERT_EQ(otherNamespace::embeddedIndex(copied), 0);
+	ASSERT_EQ(otherNamespace::embeddedIndex(builtOther), otherNamespace::FileInfo::noFileIndex);
+	ASSERT_EQ(builtOther.name(), "");
+	ASSERT_EQ(otherNamespace::findFile("other-input/other.bin"), &otherNamespace::fileInfoList[0]);
+
+	// check lookup by normalized name (generated with -index normalized)
+	ASSERT_EQ(myNamespace::findFileNormalized("input/golden_master.bin"), &myNamespace::fileInfoList[0]);
+	ASSERT_EQ(myNamespace::findFileNormalized(".\\Input\\.\\Golden_Master.BIN"), &myNamespace::fileInfoList[0]);
+	ASSERT_EQ(myNamespace::findFileNormalized("/input//golden_master.bin/"), &myNamespace::fileInfoList[0]);
+	ASSERT_EQ(myNamespace::findFileNormalized("input/golden_master.bi"), nullptr);
+	ASSERT_EQ(myNamespace::findFileNormalized("input/golden_master.bin2"), nullptr);
+	ASSERT_EQ(myNamespace::findFileNormalized(""), nullptr);
+
+	// check the secondary indexes (generated with -index extension -tag *.bin=binary)
+	ASSERT_EQ(myNamespace::filesByExtension(".bin").size(), 1);
+	ASSERT_EQ(&*myNamespace::filesByExtension(".bin").begin(), &myNamespace::fileInfoList[0]);
+	ASSERT_EQ(myNamespace::filesByExtension(".glsl").size(), 0);
+	ASSERT_EQ(myNamespace::filesByExtension("").size(), 0);
+	ASSERT_EQ(myNamespace::filesByTag("binary").size(), 1);
+	ASSERT_EQ(myNamespace::filesByTag("preload").size(), 0);
+	// generated with -tag **/input/*.bin=input: "**/" matches no directory too
+	ASSERT_EQ(myNamespace::filesByTag("input").size(), 1);
+
+	// check the lookup by content hash (generated with -index hash)
+	for (auto & file : myNamespace::fileList()) {
+		ASSERT_EQ(myNamespace::contentHash(file), myNamespace::hashContent(file.fileData, file.fileDataSize));
+		ASSERT_EQ(myNamespace::findFileByHash(myNamespace::contentHash(file)), &file);
+	}
+	ASSERT_EQ(myNamespace::findFileByHash(myNamespace::hashContent("", 0)), nullptr);
+	const myNamespace::FileInfo unlisted{ "unlisted", "abc", 3, myNamespace::FileInfo::noFileIndex };
+	ASSERT_EQ(myNamespace::contentHash(unlisted), myNamespace::hashContent("abc", 3));
+	const myNamespace::FileInfo built{ "built", "abcd", 4, 0 };
+	ASSERT_EQ(myNamespace::contentHash(built), myNamespace::hashContent("abcd", 4));
+
+	// check the integrity verification (generated with -crc 64)
+	ASSERT_EQ(myNamespace::crcBlockSize, 64);
+	for (auto & file : myNamespace::fileList()) {
+		ASSERT_EQ(myNamespace::verifyContent(file, 100, 10), true);
+		ASSERT_EQ(myNamespace::verifyContent(file, 300, 10), true);
+		ASSERT_EQ(myNamespace::verifyContent(file), true);
+		// a copy is verified as the entry it was copied from
+		const myNamespace::FileInfo copy = file;
+		ASSERT_EQ(myNamespace::verifyContent(copy), true);
+		// the accessors verify the blocks they read
+		char buffer[10];
+		ASSERT_EQ(file.copyContent(buffer, sizeof(buffer), 300), 0);
+		ASSERT_EQ(file.copyContent(buffer, sizeof(buffer), 100), 10);
+		ASSERT_EQ(file.content().size(), file.fileDataSize);
+	}
+	// the files from elsewhere aren't verified
+	ASSERT_EQ(unlisted.content(), "abc");
+	ASSERT_EQ(myNamespace::verifyContent(built), false);
+	ASSERT_EQ(built.content(), "abcd");
+	// larger than the first entry: its blocks aren't read past the end
+	static const char largeData[1000] = {};
+	const myNamespace::FileInfo large{ "large", largeData, sizeof(largeData), 0 };
+	ASSERT_EQ(large.content().size(), sizeof(largeData));
+	myNamespace::startVerify();
+	ASSERT_EQ(myNamespace::waitVerified(), true);
+
+	// check the overlay virtual filesystem (generated with -vfs)
+	{
+		myNamespace::Vfs vfs;
+		vfs.addBundle(myNamespace::fileList());
+		vfs.build();
+		ASSERT_EQ(vfs.size(), 1);
+		auto entry = vfs.find("input/golden_master.bin");
+		assert(entry != nullptr && !entry->onDisk());
+		ASSERT_EQ(entry->file.fileData, myNamespace::fileInfoList[0].fileData);
+		ASSERT_EQ(vfs.find("input/golden_master"), nullptr);
+
+		// the current directory overrides the embedded file (same name and content)
+		vfs.addDirectory(".");
+		vfs.build();
+		entry = vfs.find("input/golden_master.bin");
+		assert(entry != nullptr && entry->onDisk());
+		ASSERT_EQ(entry->content(), myNamespace::fileInfoList[0].content());
+
+		// a file removed since the scan can't be read, which isn't an empty content
+		std::FILE * removed = std::fopen("removed.bin", "wb");
+		assert(removed != nullptr);
+		std::fclose(removed);
+		vfs.build();
+		entry = vfs.find("removed.bin");
+		assert(entry != nullptr && entry->onDisk());
+		ASSERT_EQ(entry->content(), "");
+		std::remove("removed.bin");
+		bool thrown = false;
+		try {
+			entry->content();
+		}
+		catch (const std::runtime_error &) {
+			thrown = true;
+		}
+		ASSERT_EQ(thrown, true);
+
+#ifndef _WIN32
+		// a symbolic link to a parent directory isn't scanned again
+		assert(symlink("..", "input/loop") == 0);
+		vfs.build();
+		assert(vfs.find("input/golden_master.bin") != nullptr);
+		ASSERT_EQ(vfs.find("input/loop/input/golden_master.bin"), nullptr);
+		unlink("input/loop");
+#endif
+	}
+
+	// check the content shared between the processes (generated with -shm)
+#ifndef _WIN32
+	// the lock files are created in a directory of the user
+	mkdir("locks", 0700);
+	setenv("TMPDIR", "locks", 1);
+#endif
+	for (auto & file : myNamespace::fileList()) {
+		auto decode = [](const myNamespace::FileInfo & decoded) {
+			return decoded.content() + decoded.content();
+		};
+		const auto first = myNamespace::sharedDecode(file, "test", decode);
+		const auto second = myNamespace::sharedDecode(file, "test", decode);
+		ASSERT_EQ(first.size(), 2 * file.fileDataSize);
+		ASSERT_EQ(std::string(second.data(), second.size()), file.content() + file.content());
+		myNamespace::removeSharedContent(file, "test");
+
+		// a copy shares the segment of its entry, a file from elsewhere is decoded here
+		const myNamespace::FileInfo copy = file;
+		ASSERT_EQ(myNamespace::sharedDecode(copy, "test", decode).size(), 2 * file.fileDataSize);
+		myNamespace::removeSharedContent(copy, "test");
+		const myNamespace::FileInfo unlisted{ "unlisted", "abc", 3, myNamespace::FileInfo::noFileIndex };
+		const auto local = myNamespace::sharedDecode(unlisted, "test", decode);
+		ASSERT_EQ(local.isShared(), false);
+		ASSERT_EQ(std::string(local.data(), local.size()), "abcabc");
+	}
+#ifndef _WIN32
+	{
+		// only the directory remains, the lock files are removed once released
+		const std::string lockDirectory = "locks/bin2cpp-" + std::to_string(geteuid());
+		struct stat status;
+		ASSERT_EQ(lstat(lockDirectory.c_str(), &status), 0);
+		ASSERT_EQ((status.st_mode & 077), 0);
+		ASSERT_EQ(rmdir(lockDirectory.c_str()), 0);
+		rmdir("locks");
+		unsetenv("TMPDIR");
+	}
+#endif
+
+	// check the registry of the bundles (both generated with -register)
+	ASSERT_EQ(bin2cpp::registeredBundles().size(), 2);
+	const auto registered = bin2cpp::findRegisteredFile("input/golden_master.bin");
+	assert(registered != nullptr);
+	ASSERT_EQ(std::string(registered->bundle->name), "myNamespace");
+	ASSERT_EQ(registered->data, myNamespace::fileInfoList[0].fileData);
+	ASSERT_EQ(registered->size, 256);
+	const auto otherRegistered = bin2cpp::findRegisteredFile("other-input/other.bin");
+	assert(otherRegistered != nullptr);
+	ASSERT_EQ(std::string(otherRegistered->bundle->name), "otherNamespace");
+	ASSERT_EQ(otherRegistered->data, otherNamespace::fileInfoList[0].fileData);
+	ASSERT_EQ(bin2cpp::findRegisteredFile("input/missing.bin"), nullptr);
+
+	// check the lazily decoded content (generated with -lazy): the file repeated in 3 blocks and a half
+	for (auto & file : myNamespace::fileList()) {
+		const size_t blockSize = 65536;
+		const size_t decodedSize = 3 * blockSize + blockSize / 2;
+		std::atomic<int> decodedBlocks{ 0 };
+		const char * data = myNamespace::lazyDecode(file, decodedSize, blockSize,
+			[&](const myNamespace::FileInfo & decoded, size_t blockIndex, char * output, size_t size) {
+				ASSERT_EQ(size, (blockIndex == 3 ? blockSize / 2 : blockSize));
+				for (size_t i = 0; i < size; ++i) {
+					output[i] = decoded.fileData[(blockIndex * blockSize + i) % decoded.fileDataSize];
+				}
+				++decodedBlocks;
+			});
+		const bool lazy = myNamespace::lazyDecodeSupported();
+		ASSERT_EQ(decodedBlocks, (lazy ? 0 : 4));
+		ASSERT_EQ(data[2 * blockSize + 1], file.fileData[1]);
+		ASSERT_EQ(decodedBlocks, (lazy ? 1 : 4));
+		// a block not decoded yet is read by the kernel when given to a system call (unbuffered write)
+		std::FILE * output = std::tmpfile();
+		assert(output != nullptr);
+		std::setvbuf(output, nullptr, _IONBF, 0);
+		ASSERT_EQ(std::fwrite(data + blockSize, 1, blockSize, output), blockSize);
+		ASSERT_EQ(decodedBlocks, (lazy ? 2 : 4));
+		std::vector<char> written(blockSize);
+		std::rewind(output);
+		ASSERT_EQ(std::fread(written.data(), 1, blockSize, output), blockSize);
+		std::fclose(output);
+		ASSERT_EQ(written[1], data[blockSize + 1]);
+		for (size_t i = 0; i < decodedSize; ++i) {
+			ASSERT_EQ(data[i], file.fileData[i % file.fileDataSize]);
+		}
+		ASSERT_EQ(decodedBlocks, 4);
+	}
+	// the FileInfo is copied (a temporary here), and a block whose decoding throws is left filled with zeros
+	{
+		const size_t blockSize = 65536;
+		const char * data = nullptr;
+		try {
+			data = myNamespace::lazyDecode(myNamespace::FileInfo{ "temporary", "abcd", 4, myNamespace::FileInfo::noFileIndex }, 2 * blockSize, blockSize,
+				[](const myNamespace::FileInfo & decoded, size_t blockIndex, char * output, size_t size) {
+					if (blockIndex == 1) {
+						throw std::runtime_error{ "corrupted block" };
+					}
+					for (size_t i = 0; i < size; ++i) {
+						output[i] = decoded.fileData[i % decoded.fileDataSize];
+					}
+				});
+		}
+		catch (const std::runtime_error &) {
+			// decoded now: the exception is thrown by lazyDecode()
+		}
+		ASSERT_EQ((data != nullptr), myNamespace::lazyDecodeSupported());
+		if (data != nullptr) {
+			ASSERT_EQ(data[5], 'b');
+			ASSERT_EQ(data[blockSize + 1], 0);
+		}
+	}
+
+	// check preloading (the file is listed in preload.txt)
+	myNamespace::startPreload();
+	for (auto file : myNamespace::fileList()) {
+		// copies wait for their entry
+		myNamespace::waitPreloaded(file);
+	}
+
+	// check asynchronous access (generated with -async)
+	for (auto & file : myNamespace::fileList()) {
+		ASSERT_EQ(myNamespace::loadContentAsync(file).get(), file.content());
+
+		std::promise<std::string> received;
+		myNamespace::loadContentAsync(file, [&received](std::string data) {
+			received.set_value(std::move(data));
+		});
+		ASSERT_EQ(received.get_future().get(), file.content());
+	}
+	// the FileInfo is copied: temporaries can be given
+	std::future<std::string> pending = myNamespace::loadContentAsync(myNamespace::FileInfo{ "temporary", "abcd", 4, myNamespace::FileInfo::noFileIndex });
+	ASSERT_EQ(pending.get(), "abcd");
+	std::promise<std::string> received;
+	myNamespace::loadContentAsync(myNamespace::FileInfo{ "temporary", "efgh", 4, myNamespace::FileInfo::noFileIndex }, [&received](std::string data) {
+		received.set_value(std::move(data));
+	});
+	ASSERT_EQ(received.get_future().get(), "efgh");
+
+	// check the members of the zip archive (generated with -archives archive.zip), one deflated and one stored
+	ASSERT_EQ(archiveNamespace::fileList().size(), 2);
+	ASSERT_EQ((archiveNamespace::findFile("archive.zip/golden_master.bin") != nullptr), true);
+	ASSERT_EQ((archiveNamespace::findFile("archive.zip/stored/golden_master.bin") != nullptr), true);
+	for (auto file : archiveNamespace::fileList()) {
+		ASSERT_EQ(file.fileDataSize, 256);
+		for (size_t i = 0; i < 256; ++i) {
+			ASSERT_EQ(static_cast<unsigned char>(file.fileData[i]), i);
+		}
+	}
+
+	// check the members of the archives written in a pack (generated with -pack archive.pak input -archives archive.tar.gz archive.zip)
+	// archive.tar.gz holds a placeholder golden_master.bin, large.bin (golden_master.bin repeated up to 10 MB)
+	// then the real golden_master.bin: the last version is embedded, read from the checkpoint saved after 8 MB
+	packNamespace::Pack pack;
+	ASSERT_EQ(pack.open("output/archive.pak"), true);
+	ASSERT_EQ(pack.size(), 5);
+	const char * goldenMembers[] = { "archive.tar.gz/golden_master.bin", "archive.zip/golden_master.bin", "archive.zip/stored/golden_master.bin" };
+	for (const char * name : goldenMembers) {
+		const packNamespace::FileInfo member = pack.find(name);
+		ASSERT_EQ(member.fileDataSize, 256);
+		for (size_t i = 0; i < 256; ++i) {
+			ASSERT_EQ(static_cast<unsigned char>(member.fileData[i]), i);
+		}
+	}
+	const packNamespace::FileInfo largeMember = pack.find("archive.tar.gz/large.bin");
+	ASSERT_EQ(largeMember.fileDataSize, 10 * 1024 * 1024);
+	for (size_t i = 0; i < largeMember.fileDataSize; ++i) {
+		ASSERT_EQ(static_cast<unsigned char>(largeMember.fileData[i]), i % 256);
+	}
+
+	// check the lookups in the pack, by name and by position
+	const packNamespace::FileInfo packed = pack.find("input/golden_master.bin");
+	ASSERT_EQ(packed.fileDataSize, 256);
+	for (size_t i = 0; i < 256; ++i) {
+		ASSERT_EQ(static_cast<unsigned char>(packed.fileData[i]), i);
+	}
+	ASSERT_EQ(pack.find("input/golden_master.bi").fileData, nullptr);
+	ASSERT_EQ(pack.find("").fileData, nullptr);
+	size_t packedFiles = 0;
+	for (auto file : pack) {
+		ASSERT_EQ(pack.find(file.fileName).fileData, file.fileData);
+		++packedFiles;
+	}
+	ASSERT_EQ(packedFiles, pack.size());
+
+	// a truncated or corrupted pack is rejected
+	std::string packData;
+	{
+		std::FILE * input = std::fopen("output/archive.pak", "rb");
+		assert(input != nullptr);
+		char buffer[65536];
+		for (size_t read; (read = std::fread(buffer, 1, sizeof(buffer), input)) != 0;) {
+			packData.append(buffer, read);
+		}
+		std::fclose(input);
+	}
+	auto openModified = [&packData](size_t size, size_t offset, const void * value, size_t valueSize) {
+		std::string modified = packData.substr(0, size);
+		std::memcpy(&modified[offset], value, valueSize);
+		std::FILE * output = std::fopen("output/modified.pak", "wb");
+		assert(output != nullptr);
+		ASSERT_EQ(std::fwrite(modified.data(), 1, modified.size(), output), modified.size());
+		std::fclose(output);
+		packNamespace::Pack modifiedPack;
+		const bool opened = modifiedPack.open("output/modified.pak");
+		std::remove("output/modified.pak");
+		return opened;
+	};
+	std::uint64_t entriesOffset = 0;
+	std::memcpy(&entriesOffset, &packData[32], sizeof(entriesOffset));
+	const std::uint64_t outOfPack = packData.size();
+	ASSERT_EQ(openModified(packData.size(), 0, "B", 1), true);
+	ASSERT_EQ(openModified(packData.size() - 1, 0, "B", 1), false);
+	ASSERT_EQ(openModified(40, 0, "B", 1), false);
+	ASSERT_EQ(openModified(packData.size(), 0, "X", 1), false);
+	// the data of the first file out of the pack
+	ASSERT_EQ(openModified(packData.size(), static_cast<size_t>(entriesOffset) + 16, &outOfPack, sizeof(outOfPack)), false);
+	// the name of the first file not null terminated
+	const std::uint32_t longName = 0xFFFFFFF0;
+	ASSERT_EQ(openModified(packData.size(), static_cast<size_t>(entriesOffset) + 12, &longName, sizeof(longName)), false);
+	ASSERT_EQ(pack.find("input/golden_master.bin").fileData, packed.fileData);
+	pack.close();
+	ASSERT_EQ(pack.size(), 0);
+	ASSERT_EQ(pack.find("input/golden_master.bin").fileData, nullptr);
+
+	// check the groups of files loaded from shared libraries (generated with -dlgroup big -dlgroup missing):
+	// libgrouped_big.so (grouped_big.dll) is built in output, the library of the missing group isn't
+	groupNamespace::setGroupLibraryDirectory("output");
+	ASSERT_EQ(groupNamespace::fileList().size(), 0);
+	const groupNamespace::GroupFileRange group = groupNamespace::loadGroup("big");
+	ASSERT_EQ(group.size(), 1);
+	for (auto & file : group) {
+		ASSERT_EQ(file.name(), "input/golden_master.bin");
+		ASSERT_EQ(file.fileDataSize, 256);
+		for (size_t i = 0; i < 256; ++i) {
+			ASSERT_EQ(static_cast<unsigned char>(file.fileData[i]), i);
+		}
+	}
+	// the library is only loaded once
+	ASSERT_EQ(groupNamespace::loadGroup("big").begin(), group.begin());
+	ASSERT_EQ(groupNamespace::loadGroup("missing").size(), 0);
+	ASSERT_EQ(groupNamespace::loadGroup("unknown").size(), 0);
+
+	// check the files whose data is split in shards (generated with -shards 2)
+	ASSERT_EQ(shardNamespace::fileList().size(), 2);
+	ASSERT_EQ((shardNamespace::findFile("input/golden_master.bin") != nullptr), true);
+	ASSERT_EQ((shardNamespace::findFile("other-input/other.bin") != nullptr), true);
+	for (auto & file : shardNamespace::fileList()) {
+		ASSERT_EQ(file.fileDataSize, 256);
+		for (size_t i = 0; i < 256; ++i) {
+			ASSERT_EQ(static_cast<unsigned char>(file.fileData[i]), i);
+		}
+	}
+
+	// check the transformed files (generated with -transform *.json=json -transform *.glsl=strip -transform *.txt=cmd:sort)
+	ASSERT_EQ(transformNamespace::findFile("transform-input/data.json")->content(),
+		"{\"name\":\"golden master\",\"sizes\":[1,2,3],\"escaped\":\"a \\\"quoted\\\" \\\\ value\"}");
+	ASSERT_EQ(transformNamespace::findFile("transform-input/shader.glsl")->content(),
+		"#version 330\nvoid main() {\ngl_Position = vec4(0.0);\n}\n");
+	// the line breaks written by sort depend on the system
+	std::string sorted = transformNamespace::findFile("transform-input/names.txt")->content();
+	sorted.erase(std::remove(sorted.begin(), sorted.end(), '\r'), sorted.end());
+	ASSERT_EQ(sorted, "alpha\nbravo\ncharlie\n");
 }